@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "Templates/Tuple.h"
+#include "Templates/IntegerSequence.h"
 
 /*
 * Expands a tuple into a list of function arguments. 
@@ -21,3 +22,33 @@
 #define _TARGS10(T) _TARGS9(T), T.Get<9>()
 #define _TARGS11(T) _TARGS10(T), T.Get<10>()
 
+/*
+* Variadic versions of the above, for any number of elements.
+*/
+namespace PCPP_Tuple {
+	namespace Private {
+		template<typename TupleType, typename F, uint32... Indices>
+		FORCEINLINE decltype(auto) Apply(TupleType& Tuple, F& Foo, TIntegerSequence<uint32, Indices...>) {
+			return Foo(Tuple.template Get<Indices>()...);
+		}
+
+		template<typename TupleType, typename F, uint32... Indices>
+		FORCEINLINE void ForEach(TupleType& Tuple, F& Foo, TIntegerSequence<uint32, Indices...>) {
+			// Braced initialization keeps the calls in order.
+			int32 Ordered[] = { 0, (Foo(Tuple.template Get<Indices>()), 0)... };
+			(void)Ordered;
+		}
+	}
+
+	// Calls Foo with the elements of Tuple as its arguments. (_TARGS)
+	template<typename F, typename... Types>
+	FORCEINLINE decltype(auto) Apply(TTuple<Types...>& Tuple, F Foo) {
+		return Private::Apply(Tuple, Foo, TMakeIntegerSequence<uint32, sizeof...(Types)>());
+	}
+
+	// Calls Foo on every element of Tuple, first to last.
+	template<typename F, typename... Types>
+	FORCEINLINE void ForEach(TTuple<Types...>& Tuple, F Foo) {
+		Private::ForEach(Tuple, Foo, TMakeIntegerSequence<uint32, sizeof...(Types)>());
+	}
+}
@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "Kismet/KismetMathLibrary.h"
 #include "Serialization/JsonSerializer.h"
+#include "Engine/NetSerialization.h"
 
 /**
  * A collection of common (purely data based) patterns for interacting with UE4.
@@ -250,6 +251,72 @@ public:
 		}
 	};
 
+	/*
+	* Compact serialization for replication payloads (ie: INetReplicatable::SerializeReplication).
+	* Each helper is symmetric, the same call writes when the archive is saving and reads when it is loading.
+	*/
+	class Quantize {
+		public:
+		// Float in [Min, Max] using Bits (1-24, a float's precision) of precision. Out of range values and Bits are clamped.
+		// An empty range (Max <= Min) writes nothing and always reads Min.
+		static void Float(FArchive& Ar, float& Value, float Min, float Max, int32 Bits = 16) {
+			checkSlow(Max >= Min);
+			if (Max <= Min) {
+				if (Ar.IsLoading()) {
+					Value = Min;
+				}
+				return;
+			}
+			Bits = FMath::Clamp(Bits, 1, 24);
+			uint32 Steps = (uint32)((1ull << Bits) - 1);
+			uint32 Quantized = 0;
+			if (Ar.IsSaving()) {
+				float Alpha = (FMath::Clamp(Value, Min, Max) - Min) / (Max - Min);
+				Quantized = (uint32)FMath::RoundToInt(Alpha * Steps);
+			}
+			Ar.SerializeBits(&Quantized, Bits);
+			if (Ar.IsLoading()) {
+				Value = Min + (Max - Min) * ((float)Quantized / Steps);
+			}
+		}
+
+		// Location with 0.1 unit precision.
+		static bool Vector(FArchive& Ar, FVector& Value) {
+			return SerializePackedVector<10, 24>(Value, Ar);
+		}
+
+		// Location with whole unit precision.
+		static bool VectorCoarse(FArchive& Ar, FVector& Value) {
+			return SerializePackedVector<1, 24>(Value, Ar);
+		}
+
+		// Unit vector, ie: directions / normals.
+		static bool Normal(FArchive& Ar, FVector& Value) {
+			return SerializeFixedVector<1, 16>(Value, Ar);
+		}
+
+		// 2 bytes (Short) or 1 byte per non-zero component.
+		static void Rotator(FArchive& Ar, FRotator& Value, bool Short = true) {
+			if (Short) {
+				Value.SerializeCompressedShort(Ar);
+			} else {
+				Value.SerializeCompressed(Ar);
+			}
+		}
+
+		// A single bit.
+		static void Bool(FArchive& Ar, bool& Value) {
+			uint8 Bit = Value ? 1 : 0;
+			Ar.SerializeBits(&Bit, 1);
+			Value = (Bit != 0);
+		}
+
+		// Variable length, small values take a single byte.
+		static void Int(FArchive& Ar, uint32& Value) {
+			Ar.SerializeIntPacked(Value);
+		}
+	};
+
 	/* Utilities that operate so long as an enum fulfills the PCPP_UE4 enum interface.
 		All that it required is for the last member of the enum to be "MAX"
 	*/
@@ -0,0 +1,34 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NetLoadTestGameMode.h"
+#include "NetLoadTestPawn.h"
+#include "Kismet/GameplayStatics.h"
+
+ANetLoadTestGameMode::ANetLoadTestGameMode() {
+	DefaultPawnClass = ANetLoadTestPawn::StaticClass();
+	BotCount = 0;
+	BotSpacing = 2500.f;
+}
+
+void ANetLoadTestGameMode::InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) {
+	Super::InitGame(MapName, Options, ErrorMessage);
+	BotCount = FMath::Max(UGameplayStatics::GetIntOption(Options, TEXT("Pawns"), 32), 0);
+}
+
+void ANetLoadTestGameMode::StartPlay() {
+	Super::StartPlay();
+
+	FActorSpawnParameters Parameters;
+	Parameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	int32 Columns = FMath::Max(FMath::CeilToInt(FMath::Sqrt((float)BotCount)), 1);
+	for (int32 i = 0; i < BotCount; ++i) {
+		FVector Location((i % Columns) * BotSpacing, (i / Columns) * BotSpacing, 100.f);
+		auto Pawn = GetWorld()->SpawnActor<ANetLoadTestPawn>(Location, FRotator::ZeroRotator, Parameters);
+		auto Controller = GetWorld()->SpawnActor<ANetLoadTestController>(Parameters);
+		if (Pawn && Controller) {
+			Controller->Possess(Pawn);
+		}
+	}
+}
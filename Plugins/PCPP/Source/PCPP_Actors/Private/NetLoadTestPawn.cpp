@@ -0,0 +1,19 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NetLoadTestPawn.h"
+
+ANetLoadTestPawn::ANetLoadTestPawn() {
+	bReplicates = true;
+	SetReplicatingMovement(false);
+
+	Root = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+	SetRootComponent(Root);
+
+	NetReplicate = CreateDefaultSubobject<UNetReplicate>(TEXT("NetReplicate"));
+	NetReplicate->SetIsReplicated(true);
+
+	PollingComponent = CreateDefaultSubobject<UPollingClientComponent>(TEXT("PollingComponent"));
+	RPGCore = CreateDefaultSubobject<URPGCore>(TEXT("RPGCore"));
+	LoadTest = CreateDefaultSubobject<UT_NetLoadTestComponent>(TEXT("LoadTest"));
+}
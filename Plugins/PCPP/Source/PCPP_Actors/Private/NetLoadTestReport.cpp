@@ -0,0 +1,180 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NetLoadTestReport.h"
+#include "T_NetLoadTestComponent.h"
+#include "Engine/World.h"
+#include "Engine/NetDriver.h"
+#include "Engine/NetConnection.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/PlatformProcess.h"
+#include "UObject/UObjectIterator.h"
+#include "PCPP_UE4.h"
+
+static const TCHAR* NetLoadTestRPCNames[] = {
+	TEXT("OwnerReliable"),
+	TEXT("OwnerUnreliable"),
+	TEXT("OwnerMessages"),
+	TEXT("OwnerAck"),
+	TEXT("PredictionAck"),
+	TEXT("ServerReliable"),
+	TEXT("ServerUnreliable"),
+	TEXT("ServerMessages"),
+	TEXT("ClientAck")
+};
+
+namespace NetLoadTestReport {
+	static TSharedPtr<FJsonObject> Percentiles(TArray<float>& Values) {
+		TSharedPtr<FJsonObject> Out = MakeShareable(new FJsonObject());
+		Values.Sort();
+		auto At = [&Values](float P) {
+			return Values.Num() > 0 ? Values[FMath::Clamp(FMath::CeilToInt(P * Values.Num()) - 1, 0, Values.Num() - 1)] : 0.f;
+		};
+		Out->SetNumberField("Samples", Values.Num());
+		Out->SetNumberField("P50Ms", At(0.5f));
+		Out->SetNumberField("P95Ms", At(0.95f));
+		Out->SetNumberField("P99Ms", At(0.99f));
+		Out->SetNumberField("MaxMs", Values.Num() > 0 ? Values.Last() : 0.f);
+		return Out;
+	}
+}
+
+UNetLoadTestReport::UNetLoadTestReport() {
+	Enabled = false;
+	Finished = false;
+	WarmupSeconds = 5.f;
+	MeasureSeconds = 30.f;
+	Elapsed = 0.f;
+	SinceConnectionSample = 0.f;
+	StartPollsSent = 0;
+	StartPollsAnswered = 0;
+	StartPollsTimedOut = 0;
+	StartHitsReceived = 0;
+	FMemory::Memzero(StartRPCCounts);
+	FMemory::Memzero(StartRPCBytes);
+}
+
+void UNetLoadTestReport::Initialize(FSubsystemCollectionBase& Collection) {
+	Super::Initialize(Collection);
+	Enabled = FParse::Param(FCommandLine::Get(), TEXT("PCPPLoadTest"));
+	FParse::Value(FCommandLine::Get(), TEXT("PCPPLoadTestSeconds="), MeasureSeconds);
+	if (!FParse::Value(FCommandLine::Get(), TEXT("PCPPLoadTestReport="), Directory)) {
+		Directory = FPaths::Combine(FPaths::AutomationDir(), TEXT("NetLoadTest"));
+	}
+}
+
+void UNetLoadTestReport::Begin() {
+	FMemory::Memcpy(StartRPCCounts, UNetReplicate::RPCCounts, sizeof(StartRPCCounts));
+	FMemory::Memcpy(StartRPCBytes, UNetReplicate::RPCBytes, sizeof(StartRPCBytes));
+	StartPollsSent = UT_NetLoadTestComponent::PollsSent;
+	StartPollsAnswered = UT_NetLoadTestComponent::PollsAnswered;
+	StartPollsTimedOut = UT_NetLoadTestComponent::PollsTimedOut;
+	StartHitsReceived = UT_NetLoadTestComponent::HitsReceived;
+}
+
+void UNetLoadTestReport::SampleConnections() {
+	auto NetDriver = GetWorld()->GetNetDriver();
+	if (!NetDriver) {
+		return;
+	}
+	auto Sample = [this](UNetConnection* Connection) {
+		if (Connection) {
+			auto& Samples = Connections.FindOrAdd(Connection->LowLevelGetRemoteAddress(true));
+			Samples.InBytesPerSecond += Connection->InBytesPerSecond;
+			Samples.OutBytesPerSecond += Connection->OutBytesPerSecond;
+			Samples.Samples++;
+		}
+	};
+	Sample(NetDriver->ServerConnection);
+	for (auto Connection : NetDriver->ClientConnections) {
+		Sample(Connection);
+	}
+}
+
+void UNetLoadTestReport::Tick(float DeltaTime) {
+	Elapsed += DeltaTime;
+	if (Elapsed < WarmupSeconds) {
+		return;
+	}
+	if (FrameMs.Num() == 0) {
+		Begin();
+	}
+
+	FrameMs.Add(DeltaTime * 1000.f);
+	GameThreadMs.Add(FPlatformTime::ToMilliseconds(GGameThreadTime));
+
+	// Connections update their rates once per second.
+	SinceConnectionSample += DeltaTime;
+	if (SinceConnectionSample >= 1.f) {
+		SinceConnectionSample -= 1.f;
+		SampleConnections();
+	}
+
+	if (Elapsed >= WarmupSeconds + MeasureSeconds) {
+		Finish();
+	}
+}
+
+void UNetLoadTestReport::Finish() {
+	Finished = true;
+	float Seconds = Elapsed - WarmupSeconds;
+	bool IsServer = GetWorld()->GetNetMode() == NM_DedicatedServer || GetWorld()->GetNetMode() == NM_ListenServer;
+
+	int32 Pawns = 0;
+	for (TObjectIterator<UT_NetLoadTestComponent> It; It; ++It) {
+		if (It->GetWorld() == GetWorld()) {
+			Pawns++;
+		}
+	}
+
+	FJsonObject Report;
+	Report.SetStringField("Role", IsServer ? TEXT("Server") : TEXT("Client"));
+	Report.SetNumberField("ProcessId", FPlatformProcess::GetCurrentProcessId());
+	Report.SetNumberField("Seconds", Seconds);
+	Report.SetNumberField("Pawns", Pawns);
+	Report.SetObjectField("Frame", NetLoadTestReport::Percentiles(FrameMs));
+	Report.SetObjectField("GameThread", NetLoadTestReport::Percentiles(GameThreadMs));
+
+	TArray<TSharedPtr<FJsonValue>> ConnectionValues;
+	for (auto It = Connections.CreateConstIterator(); It; ++It) {
+		TSharedPtr<FJsonObject> Connection = MakeShareable(new FJsonObject());
+		int32 Samples = FMath::Max(It->Value.Samples, 1);
+		Connection->SetStringField("Address", It->Key);
+		Connection->SetNumberField("InBytesPerSecond", It->Value.InBytesPerSecond / Samples);
+		Connection->SetNumberField("OutBytesPerSecond", It->Value.OutBytesPerSecond / Samples);
+		ConnectionValues.Add(MakeShareable(new FJsonValueObject(Connection)));
+	}
+	Report.SetArrayField("Connections", ConnectionValues);
+
+	TSharedPtr<FJsonObject> RPCs = MakeShareable(new FJsonObject());
+	for (int32 i = 0; i < ENetReplicateRPC::MAX; ++i) {
+		TSharedPtr<FJsonObject> RPC = MakeShareable(new FJsonObject());
+		int64 Count = UNetReplicate::RPCCounts[i] - StartRPCCounts[i];
+		int64 Bytes = UNetReplicate::RPCBytes[i] - StartRPCBytes[i];
+		RPC->SetNumberField("Count", (double)Count);
+		RPC->SetNumberField("PerSecond", Count / FMath::Max(Seconds, 1.f));
+		RPC->SetNumberField("BytesPerSecond", Bytes / FMath::Max(Seconds, 1.f));
+		RPCs->SetObjectField(NetLoadTestRPCNames[i], RPC);
+	}
+	Report.SetObjectField("RPCs", RPCs);
+	Report.SetNumberField("PollsSent", (double)(UT_NetLoadTestComponent::PollsSent - StartPollsSent));
+	Report.SetNumberField("PollsAnswered", (double)(UT_NetLoadTestComponent::PollsAnswered - StartPollsAnswered));
+	Report.SetNumberField("PollsTimedOut", (double)(UT_NetLoadTestComponent::PollsTimedOut - StartPollsTimedOut));
+	Report.SetNumberField("HitsReceived", (double)(UT_NetLoadTestComponent::HitsReceived - StartHitsReceived));
+
+	FString OutputPath = FPaths::Combine(Directory, FString::Printf(TEXT("%s_%u.json"), IsServer ? TEXT("Server") : TEXT("Client"), FPlatformProcess::GetCurrentProcessId()));
+	FFileHelper::SaveStringToFile(PCPP_UE4::JSON::ToString(Report), *OutputPath);
+	UE_LOG(LogTemp, Log, TEXT("NetLoadTest report written to %s"), *OutputPath);
+
+	FPlatformMisc::RequestExit(false);
+}
+
+bool UNetLoadTestReport::IsTickable() const {
+	return Enabled && !Finished && GetWorld() && GetWorld()->IsGameWorld();
+}
+
+TStatId UNetLoadTestReport::GetStatId() const {
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UNetLoadTestReport, STATGROUP_Tickables);
+}
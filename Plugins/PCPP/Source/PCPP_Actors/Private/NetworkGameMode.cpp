@@ -4,6 +4,7 @@
 #include "NetworkGameMode.h"
 #include "EngineUtils.h"
 #include "Kismet/GameplayStatics.h"
+#include "NetReplicateScheduler.h"
 
 ANetworkGameMode::ANetworkGameMode() {
 	RuleSet = nullptr;
@@ -26,5 +27,7 @@ void ANetworkGameMode::LoadRuleSet(TSubclassOf<URuleSet> RuleSetClass) {
 	if (!RuleSet) {
 		RuleSet = NewObject<URuleSet>(this, RuleSetClass);
 		RuleSet->InitRuleSet(GetTeamSpawnPoints());
+		// Teams for ENetReplicationAudience::TeamOnly replication.
+		GetWorld()->GetSubsystem<UNetReplicateScheduler>()->TeamResolver.BindUObject(RuleSet, &URuleSet::GetTeam);
 	}
 }
@@ -0,0 +1,128 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "PCPP_UE4.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/*
+* Loopback load test for UNetReplicate, UPollingClientComponent and URPGCore.
+* Launches a dedicated server (ANetLoadTestGameMode with M scripted pawns) and N clients as local processes connected over 127.0.0.1,
+* each process measures itself with UNetLoadTestReport. The per process reports are merged into a single JSON in the automation directory.
+*
+* Usage: UE4Editor-Cmd <Project> -nullrhi -unattended -ExecCmds="Automation RunTests PCPP.Net.LoadTest; Quit"
+*/
+
+namespace NetLoadTest {
+	static const TCHAR* Map = TEXT("/Game/Test/PollerTest");
+	static const int32 Port = 17777;
+
+	// Seconds every process measures for, after its warm up.
+	static const int32 MeasureSeconds = 30;
+
+	// Extra seconds for startup, connecting and warm up before the processes are killed.
+	static const double Timeout = 120.0;
+
+	static FProcHandle Launch(const FString& Arguments) {
+		return FPlatformProcess::CreateProc(FPlatformProcess::ExecutablePath(), *Arguments, true, true, true, nullptr, 0, nullptr, nullptr);
+	}
+
+	// Arguments every process shares.
+	static FString CommonArguments(const FString& ReportDirectory) {
+		FString Project = FPaths::IsProjectFilePathSet() ? FPaths::GetProjectFilePath() : FString();
+		return FString::Printf(TEXT("\"%s\" -nullrhi -unattended -nosound -nosplash -log -PCPPLoadTest -PCPPLoadTestSeconds=%d -PCPPLoadTestReport=\"%s\""),
+			*FPaths::ConvertRelativePathToFull(Project), MeasureSeconds, *ReportDirectory);
+	}
+}
+
+IMPLEMENT_COMPLEX_AUTOMATION_TEST(FNetLoadTest, "PCPP.Net.LoadTest", EAutomationTestFlags::EngineFilter | EAutomationTestFlags::ClientContext | EAutomationTestFlags::PerfFilter)
+
+void FNetLoadTest::GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const {
+	// Clients, Pawns.
+	const TArray<FIntPoint> Configurations = { FIntPoint(2, 32), FIntPoint(8, 64), FIntPoint(16, 128) };
+	for (auto It = Configurations.CreateConstIterator(); It; ++It) {
+		OutBeautifiedNames.Add(FString::Printf(TEXT("%d Clients %d Pawns"), It->X, It->Y));
+		OutTestCommands.Add(FString::Printf(TEXT("%d %d"), It->X, It->Y));
+	}
+}
+
+bool FNetLoadTest::RunTest(const FString& Parameters) {
+	using namespace NetLoadTest;
+	FString ClientsString, PawnsString;
+	Parameters.Split(TEXT(" "), &ClientsString, &PawnsString);
+	int32 ClientCount = FCString::Atoi(*ClientsString);
+	int32 PawnCount = FCString::Atoi(*PawnsString);
+
+	FString ReportDirectory = FPaths::ConvertRelativePathToFull(FPaths::Combine(FPaths::AutomationDir(), FString::Printf(TEXT("NetLoadTest_%d_%d"), ClientCount, PawnCount)));
+	IFileManager::Get().DeleteDirectory(*ReportDirectory, false, true);
+	IFileManager::Get().MakeDirectory(*ReportDirectory, true);
+
+	TArray<FProcHandle> Processes;
+	Processes.Add(Launch(FString::Printf(TEXT("%s %s?game=/Script/PCPP_Actors.NetLoadTestGameMode?Pawns=%d -server -port=%d"),
+		*CommonArguments(ReportDirectory), Map, PawnCount, Port)));
+
+	// Give the server a moment to listen.
+	FPlatformProcess::Sleep(5.f);
+	for (int32 i = 0; i < ClientCount; ++i) {
+		Processes.Add(Launch(FString::Printf(TEXT("%s 127.0.0.1:%d -game -windowed -ResX=320 -ResY=240"), *CommonArguments(ReportDirectory), Port)));
+	}
+
+	// Every process exits on its own once it wrote its report.
+	double Deadline = FPlatformTime::Seconds() + MeasureSeconds + Timeout;
+	for (auto& Process : Processes) {
+		while (Process.IsValid() && FPlatformProcess::IsProcRunning(Process) && FPlatformTime::Seconds() < Deadline) {
+			FPlatformProcess::Sleep(0.5f);
+		}
+		if (Process.IsValid() && FPlatformProcess::IsProcRunning(Process)) {
+			FPlatformProcess::TerminateProc(Process, true);
+		}
+		FPlatformProcess::CloseProc(Process);
+	}
+
+	// Merge the reports.
+	TArray<FString> Files;
+	IFileManager::Get().FindFiles(Files, *FPaths::Combine(ReportDirectory, TEXT("*.json")), true, false);
+
+	TArray<TSharedPtr<FJsonValue>> Clients;
+	TSharedPtr<FJsonObject> Server;
+	for (auto It = Files.CreateConstIterator(); It; ++It) {
+		FString Contents;
+		TSharedPtr<FJsonObject> Object;
+		if (!FFileHelper::LoadFileToString(Contents, *FPaths::Combine(ReportDirectory, *It)) || !FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Contents), Object) || !Object.IsValid()) {
+			AddWarning(FString::Printf(TEXT("Unreadable report %s"), **It));
+			continue;
+		}
+		if (It->StartsWith(TEXT("Server"))) {
+			Server = Object;
+		}
+		else {
+			Clients.Add(MakeShareable(new FJsonValueObject(Object)));
+		}
+	}
+
+	FJsonObject Report;
+	Report.SetNumberField("Clients", ClientCount);
+	Report.SetNumberField("Pawns", PawnCount);
+	Report.SetNumberField("MeasureSeconds", MeasureSeconds);
+	if (Server.IsValid()) {
+		Report.SetObjectField("Server", Server);
+	}
+	Report.SetArrayField("ClientReports", Clients);
+
+	FString OutputPath = FPaths::Combine(FPaths::AutomationDir(), FString::Printf(TEXT("NetLoadTest_%d_%d.json"), ClientCount, PawnCount));
+	FFileHelper::SaveStringToFile(PCPP_UE4::JSON::ToString(Report), *OutputPath);
+	AddInfo(FString::Printf(TEXT("Net load test written to %s"), *OutputPath));
+
+	TestTrue(TEXT("The server wrote a report"), Server.IsValid());
+	TestEqual(TEXT("Every client wrote a report"), Clients.Num(), ClientCount);
+	return true;
+}
+
+#endif
@@ -0,0 +1,31 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NetworkGameMode.h"
+#include "NetLoadTestGameMode.generated.h"
+
+/*
+* Game mode of the network load test. (PCPP.Net.LoadTest)
+* Every client gets an ANetLoadTestPawn, and ?Pawns=M bots are spawned on a grid and controlled by the server.
+*/
+UCLASS()
+class PCPP_ACTORS_API ANetLoadTestGameMode : public ANetworkGameMode
+{
+	GENERATED_BODY()
+
+protected:
+	int32 BotCount;
+
+public:
+	ANetLoadTestGameMode();
+
+	// Distance (cm) between bots, spread wide enough for interest management to matter.
+	UPROPERTY(EditAnywhere)
+	float BotSpacing;
+
+	virtual void InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) override;
+
+	virtual void StartPlay() override;
+};
@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/Controller.h"
+#include "NetReplicate.h"
+#include "PollingClientComponent.h"
+#include "RPGCore.h"
+#include "T_NetLoadTestComponent.h"
+#include "NetLoadTestPawn.generated.h"
+
+/*
+* Pawn spawned by the network load test, replicates only through its UNetReplicate. (Movement replication is off)
+*/
+UCLASS()
+class PCPP_ACTORS_API ANetLoadTestPawn : public APawn
+{
+	GENERATED_BODY()
+
+public:
+	ANetLoadTestPawn();
+
+	UPROPERTY()
+	USceneComponent* Root;
+
+	UPROPERTY()
+	UNetReplicate* NetReplicate;
+
+	UPROPERTY()
+	UPollingClientComponent* PollingComponent;
+
+	UPROPERTY()
+	URPGCore* RPGCore;
+
+	UPROPERTY()
+	UT_NetLoadTestComponent* LoadTest;
+};
+
+/*
+* Server side controller of the load test bots, makes the server the locally controlling owner of their pawns.
+*/
+UCLASS()
+class PCPP_ACTORS_API ANetLoadTestController : public AController
+{
+	GENERATED_BODY()
+};
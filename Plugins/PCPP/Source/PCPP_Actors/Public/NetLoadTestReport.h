@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "NetReplicate.h"
+#include "NetLoadTestReport.generated.h"
+
+/*
+* Measures a process of the network load test, only active with -PCPPLoadTest.
+* After a warm up, frame / game thread times, bytes per second of every connection and UNetReplicate RPCs are sampled
+* for -PCPPLoadTestSeconds=S, then written as JSON to -PCPPLoadTestReport=<Dir> and the process exits.
+*/
+UCLASS()
+class PCPP_ACTORS_API UNetLoadTestReport : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+protected:
+	bool Enabled;
+	bool Finished;
+
+	float WarmupSeconds;
+	float MeasureSeconds;
+	float Elapsed;
+	FString Directory;
+
+	TArray<float> FrameMs;
+	TArray<float> GameThreadMs;
+
+	// Per connection (by remote address) sums of the once per second byte rates.
+	struct FConnectionSamples {
+		double InBytesPerSecond = 0.0;
+		double OutBytesPerSecond = 0.0;
+		int32 Samples = 0;
+	};
+	TMap<FString, FConnectionSamples> Connections;
+	float SinceConnectionSample;
+
+	int64 StartRPCCounts[ENetReplicateRPC::MAX];
+	int64 StartRPCBytes[ENetReplicateRPC::MAX];
+	int64 StartPollsSent;
+	int64 StartPollsAnswered;
+	int64 StartPollsTimedOut;
+	int64 StartHitsReceived;
+
+	void Begin();
+
+	void SampleConnections();
+
+	void Finish();
+
+public:
+	UNetLoadTestReport();
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual ETickableTickType GetTickableTickType() const override { return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional; }
+};
@@ -0,0 +1,144 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DDDAnimationBudget.h"
+#include "DDDAnimationCore.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<float> CVarDDDAnimBudgetMs(
+	TEXT("pcpp.Anim.BudgetMs"),
+	0.5f,
+	TEXT("Game thread budget (ms) per frame for UDDDAnimationCore property updates."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarDDDAnimBudgetMaxDistance(
+	TEXT("pcpp.Anim.BudgetMaxDistance"),
+	20000.f,
+	TEXT("Distance (cm) at which distance stops contributing to UDDDAnimationCore significance."),
+	ECVF_Default);
+
+// Significance weights. Player owned always outranks visible, which always outranks distance.
+static const float DDDPlayerOwnedWeight = 1000.f;
+static const float DDDVisibleWeight = 100.f;
+static const float DDDDistanceWeight = 50.f;
+static const float DDDStalenessWeight = 5.f;
+
+UDDDAnimationBudget::UDDDAnimationBudget() {
+	// Conservative starting guess, refined by ReportCost.
+	AverageTaskCostMs = 0.002f;
+}
+
+void UDDDAnimationBudget::Register(UDDDAnimationCore* Instance) {
+	if (TaskBudgets.Contains(Instance)) {
+		return;
+	}
+	FDDDAnimationBudgetEntry Entry;
+	Entry.Instance = Instance;
+	Entry.Significance = 0.f;
+	Entry.FramesSinceUpdate = 0;
+	// Full update on the first frame so that the instance starts with valid data.
+	Entry.TaskBudget = Instance->GetTaskCount();
+	Entries.Add(Entry);
+	TaskBudgets.Add(Instance, Entry.TaskBudget);
+}
+
+void UDDDAnimationBudget::Unregister(UDDDAnimationCore* Instance) {
+	TaskBudgets.Remove(Instance);
+	Entries.RemoveAllSwap([Instance](const FDDDAnimationBudgetEntry& Entry) {
+		return Entry.Instance == Instance;
+	});
+}
+
+int32 UDDDAnimationBudget::GetTaskBudget(UDDDAnimationCore* Instance) {
+	// Unknown instances are not throttled.
+	auto Found = TaskBudgets.Find(Instance);
+	return Found ? *Found : Instance->GetTaskCount();
+}
+
+void UDDDAnimationBudget::ReportCost(int32 TasksRun, double Seconds) {
+	if (TasksRun > 0) {
+		float Sample = (float)(Seconds * 1000.0) / TasksRun;
+		AverageTaskCostMs = FMath::Lerp(AverageTaskCostMs, Sample, 0.05f);
+	}
+}
+
+float UDDDAnimationBudget::ComputeSignificance(UDDDAnimationCore* Instance, const FVector& ViewLocation, bool HasView) {
+	float Significance = 0.f;
+
+	auto Pawn = Instance->TryGetPawnOwner();
+	if (Pawn && Pawn->IsPlayerControlled()) {
+		Significance += DDDPlayerOwnedWeight;
+	}
+
+	auto Mesh = Instance->GetSkelMeshComponent();
+	if (Mesh && Mesh->WasRecentlyRendered(0.2f)) {
+		Significance += DDDVisibleWeight;
+	}
+
+	auto Owner = Instance->GetOwningActor();
+	if (Owner && HasView) {
+		float MaxDistance = FMath::Max(CVarDDDAnimBudgetMaxDistance.GetValueOnGameThread(), 1.f);
+		float Distance = FVector::Dist(ViewLocation, Owner->GetActorLocation());
+		Significance += DDDDistanceWeight * (1.f - FMath::Clamp(Distance / MaxDistance, 0.f, 1.f));
+	}
+
+	return Significance;
+}
+
+void UDDDAnimationBudget::Tick(float DeltaTime) {
+	// Drop anything that was destroyed without unregistering.
+	Entries.RemoveAllSwap([](const FDDDAnimationBudgetEntry& Entry) {
+		return !Entry.Instance.IsValid();
+	});
+	for (auto It = TaskBudgets.CreateIterator(); It; ++It) {
+		if (!It->Key.IsValid()) {
+			It.RemoveCurrent();
+		}
+	}
+
+	// Local view to measure distance from.
+	FVector ViewLocation = FVector::ZeroVector;
+	FRotator ViewRotation;
+	auto PlayerController = GetWorld()->GetFirstPlayerController();
+	bool HasView = (PlayerController != nullptr);
+	if (HasView) {
+		PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+	}
+
+	// Rank. Staleness lets low significance instances eventually climb above the cut.
+	for (auto It = Entries.CreateIterator(); It; ++It) {
+		It->Significance = ComputeSignificance(It->Instance.Get(), ViewLocation, HasView) + It->FramesSinceUpdate * DDDStalenessWeight;
+	}
+	Entries.Sort([](const FDDDAnimationBudgetEntry& A, const FDDDAnimationBudgetEntry& B) {
+		return A.Significance > B.Significance;
+	});
+
+	// Hand out the budget in order of significance.
+	int32 RemainingTasks = FMath::FloorToInt(CVarDDDAnimBudgetMs.GetValueOnGameThread() / FMath::Max(AverageTaskCostMs, KINDA_SMALL_NUMBER));
+	for (auto It = Entries.CreateIterator(); It; ++It) {
+		int32 Wanted = It->Instance->GetTaskCount();
+		int32 Granted = FMath::Min(Wanted, RemainingTasks);
+
+		// Player owned characters are never throttled.
+		auto Pawn = It->Instance->TryGetPawnOwner();
+		if (Pawn && Pawn->IsPlayerControlled()) {
+			Granted = Wanted;
+		}
+
+		It->TaskBudget = Granted;
+		TaskBudgets.Add(It->Instance, Granted);
+		RemainingTasks = FMath::Max(RemainingTasks - Granted, 0);
+		It->FramesSinceUpdate = (Granted > 0) ? 0 : It->FramesSinceUpdate + 1;
+	}
+}
+
+bool UDDDAnimationBudget::IsTickable() const {
+	return Entries.Num() > 0;
+}
+
+TStatId UDDDAnimationBudget::GetStatId() const {
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UDDDAnimationBudget, STATGROUP_Tickables);
+}
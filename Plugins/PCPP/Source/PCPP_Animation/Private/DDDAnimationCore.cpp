@@ -2,10 +2,10 @@
 
 
 #include "DDDAnimationCore.h"
+#include "DDDAnimationBudget.h"
 #include "PCPP_UE4.h"
 
 UDDDAnimationCore::UDDDAnimationCore() {
-	TaskIndex = 0;
 	OwnerMoveComp = nullptr;
 	MovementMode = EDDDMovementMode::DDD_Walk;
 
@@ -13,81 +13,231 @@ UDDDAnimationCore::UDDDAnimationCore() {
 	// The updates can be made less coarse in the AnimBP properties(assuming the default is used.)
 	RoundRobinMode = true;
 	BatchSize = 2;
+	BudgetMode = false;
+	DirtyMode = false;
+	LastCapturedStamp = 0;
 	Tasks = {
 		&UDDDAnimationCore::__ReplicateSpeed,
 		&UDDDAnimationCore::__ReplicateAim,
 		&UDDDAnimationCore::__ReplicateIdleTime,
 		&UDDDAnimationCore::__ReplicateTurn
 	};
+	TaskDirtyMasks = {
+		EDDDDirty::Speed,
+		EDDDDirty::Aim,
+		EDDDDirty::IdleTime,
+		EDDDDirty::Turn
+	};
 }
 
 UDDDCharacterMovement* UDDDAnimationCore::GetMoveComp() {
-	return PCPP_UE4::LazyGetCompWithInit(TryGetPawnOwner(), OwnerMoveComp, [&](UDDDCharacterMovement* Comp) {
-		(Comp->OnWalk).AddDynamic(this, &UDDDAnimationCore::__OnWalk);
-		(Comp->OnRun).AddDynamic(this, &UDDDAnimationCore::__OnRun);
-		(Comp->OnCrouch).AddDynamic(this, &UDDDAnimationCore::__OnCrouch);
-		(Comp->OnDead).AddDynamic(this, &UDDDAnimationCore::__OnDead);
-		MovementMode = Comp->GetDDDMovementMode();
-	});
-}
-
-void UDDDAnimationCore::NativeUpdateAnimation(float dt) {
-	Super::NativeUpdateAnimation(dt);
-	if (GetMoveComp()) {
-		// Correct dt to account for possible batching.
-		dt = TaskTimeElapsed(dt);
-		if (RoundRobinMode) {
-			// Perform only the requisite amount of tasks in the batch.
-			for (auto i = 0; i < BatchSize; ++i) {
-				(this->*(Tasks[i]))(dt);
-				NextTask();
-			}
-		// No Queueing, just run every task.
-		} else {
-			for (auto It = Tasks.CreateIterator(); It; ++It) {
-				(this->**It)(dt);
+	return PCPP_UE4::LazyGetComp(TryGetPawnOwner(), OwnerMoveComp);
+}
+
+FAnimInstanceProxy* UDDDAnimationCore::CreateAnimInstanceProxy() {
+	return new FDDDAnimInstanceProxy(this);
+}
+
+void UDDDAnimationCore::DestroyAnimInstanceProxy(FAnimInstanceProxy* InProxy) {
+	delete static_cast<FDDDAnimInstanceProxy*>(InProxy);
+}
+
+void UDDDAnimationCore::CaptureMovementState(UDDDCharacterMovement* MoveComp, FDDDMovementSnapshot& Out) {
+	// Only copy what changed since the last capture.
+	if (DirtyMode) {
+		Out.DirtyMask = MoveComp->GetDirtySince(LastCapturedStamp);
+		LastCapturedStamp = UDDDCharacterMovement::GetChangeStamp();
+		if (Out.DirtyMask & EDDDDirty::Mode) {
+			Out.MovementMode = MoveComp->GetDDDMovementMode();
+		}
+		if (Out.DirtyMask & EDDDDirty::Speed) {
+			Out.Speed = MoveComp->GetSpeed();
+		}
+		if (Out.DirtyMask & EDDDDirty::Aim) {
+			Out.AimPitch = MoveComp->GetAimPitch();
+			Out.AimYaw = MoveComp->GetAimYaw();
+		}
+		if (Out.DirtyMask & EDDDDirty::IdleTime) {
+			Out.IdleTime = MoveComp->GetIdleTime();
+		}
+		if (Out.DirtyMask & EDDDDirty::Turn) {
+			Out.Turn = MoveComp->GetTurn();
+		}
+		return;
+	}
+
+	Out.DirtyMask = EDDDDirty::All;
+	Out.MovementMode = MoveComp->GetDDDMovementMode();
+	Out.Speed = MoveComp->GetSpeed();
+	Out.AimPitch = MoveComp->GetAimPitch();
+	Out.AimYaw = MoveComp->GetAimYaw();
+	Out.IdleTime = MoveComp->GetIdleTime();
+	Out.Turn = MoveComp->GetTurn();
+}
+
+void UDDDAnimationCore::NativeInitializeAnimation() {
+	Super::NativeInitializeAnimation();
+	if (BudgetMode && GetWorld()) {
+		auto Budget = GetWorld()->GetSubsystem<UDDDAnimationBudget>();
+		if (Budget) {
+			Budget->Register(this);
+		}
+	}
+}
+
+void UDDDAnimationCore::NativeUninitializeAnimation() {
+	if (GetWorld()) {
+		auto Budget = GetWorld()->GetSubsystem<UDDDAnimationBudget>();
+		if (Budget) {
+			Budget->Unregister(this);
+		}
+	}
+	Super::NativeUninitializeAnimation();
+}
+
+int32 UDDDAnimationCore::__ScheduleTasks() {
+	if (BudgetMode) {
+		auto Budget = GetWorld()->GetSubsystem<UDDDAnimationBudget>();
+		return Budget ? Budget->GetTaskBudget(this) : Tasks.Num();
+	}
+	// Every task is considered, the dirty mask filters them.
+	if (DirtyMode) {
+		return Tasks.Num();
+	}
+	return RoundRobinMode ? BatchSize : Tasks.Num();
+}
+
+void UDDDAnimationCore::__RunTasks(const FDDDMovementSnapshot& Snapshot, float dt, int32 TaskCount, FDDDTaskState& State) const {
+	auto& Out = State.Output;
+	Out.MovementMode = Snapshot.MovementMode;
+
+	// Budgeted, every task ages and only the ones that run are reset.
+	if (BudgetMode) {
+		State.TaskTimeAccumulated.SetNumZeroed(Tasks.Num());
+		for (auto It = State.TaskTimeAccumulated.CreateIterator(); It; ++It) {
+			*It += dt;
+		}
+		for (auto i = 0; i < TaskCount; ++i) {
+			(this->*(Tasks[State.TaskIndex]))(Snapshot, State.TaskTimeAccumulated[State.TaskIndex], Out);
+			State.TaskTimeAccumulated[State.TaskIndex] = 0.f;
+			NextTask(State);
+		}
+		return;
+	}
+
+	// Dirty, run only the tasks whose inputs changed. Skipped tasks keep aging.
+	if (DirtyMode) {
+		State.TaskTimeAccumulated.SetNumZeroed(Tasks.Num());
+		for (auto i = 0; i < Tasks.Num(); ++i) {
+			State.TaskTimeAccumulated[i] += dt;
+			if (Snapshot.DirtyMask & __TaskMask(i)) {
+				(this->*(Tasks[i]))(Snapshot, State.TaskTimeAccumulated[i], Out);
+				State.TaskTimeAccumulated[i] = 0.f;
 			}
 		}
+		return;
+	}
+
+	// Correct dt to account for possible batching.
+	dt = TaskTimeElapsed(dt);
+	if (RoundRobinMode) {
+		// Perform only the requisite amount of tasks in the batch.
+		for (auto i = 0; i < TaskCount; ++i) {
+			(this->*(Tasks[State.TaskIndex]))(Snapshot, dt, Out);
+			NextTask(State);
+		}
+	// No Queueing, just run every task.
+	} else {
+		for (auto It = Tasks.CreateConstIterator(); It; ++It) {
+			(this->**It)(Snapshot, dt, Out);
+		}
 	}
 }
 
-void UDDDAnimationCore::NextTask() {
+void UDDDAnimationCore::__ApplyOutput(const FDDDAnimationOutput& Output) {
+	MovementMode = Output.MovementMode;
+	Speed = Output.Speed;
+	AimPitch = Output.AimPitch;
+	AimYaw = Output.AimYaw;
+	IdleTime = Output.IdleTime;
+	Turn = Output.Turn;
+}
+
+void UDDDAnimationCore::NextTask(FDDDTaskState& State) const {
 	// Cycle task resetting it if reaching end.
-	TaskIndex++;
-	if (TaskIndex >= Tasks.Num()) {
-		TaskIndex = 0;
+	State.TaskIndex++;
+	if (State.TaskIndex >= Tasks.Num()) {
+		State.TaskIndex = 0;
 	}
 }
 
-void UDDDAnimationCore::__OnCrouch() {
-	MovementMode = EDDDMovementMode::DDD_Crouch;
+void UDDDAnimationCore::__ReplicateSpeed(const FDDDMovementSnapshot& Snapshot, float dt, FDDDAnimationOutput& Out) const {
+	Out.Speed = Snapshot.Speed;
 }
 
-void UDDDAnimationCore::__OnWalk() {
-	MovementMode = EDDDMovementMode::DDD_Walk;
+void UDDDAnimationCore::__ReplicateAim(const FDDDMovementSnapshot& Snapshot, float dt, FDDDAnimationOutput& Out) const {
+	Out.AimPitch = Snapshot.AimPitch;
+	Out.AimYaw = Snapshot.AimYaw;
 }
 
-void UDDDAnimationCore::__OnRun() {
-	MovementMode = EDDDMovementMode::DDD_Run;
+void UDDDAnimationCore::__ReplicateIdleTime(const FDDDMovementSnapshot& Snapshot, float dt, FDDDAnimationOutput& Out) const {
+	Out.IdleTime = Snapshot.IdleTime;
 }
 
-void UDDDAnimationCore::__OnDead() {
-	MovementMode = EDDDMovementMode::DDD_Dead;
+void UDDDAnimationCore::__ReplicateTurn(const FDDDMovementSnapshot& Snapshot, float dt, FDDDAnimationOutput& Out) const {
+	Out.Turn = Snapshot.Turn;
 }
 
-void UDDDAnimationCore::__ReplicateSpeed(float dt) {
-	Speed = OwnerMoveComp->GetSpeed();
+FDDDAnimInstanceProxy::FDDDAnimInstanceProxy(UAnimInstance* InAnimInstance)
+	: FAnimInstanceProxy(InAnimInstance), ScheduledTasks(0), GameThreadSeconds(0.0) {
+	Core = Cast<UDDDAnimationCore>(InAnimInstance);
 }
 
-void UDDDAnimationCore::__ReplicateAim(float dt) {
-	AimPitch = OwnerMoveComp->GetAimPitch();
-	AimYaw = OwnerMoveComp->GetAimYaw();
+void FDDDAnimInstanceProxy::PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds) {
+	FAnimInstanceProxy::PreUpdate(InAnimInstance, DeltaSeconds);
+
+	// Game thread. This is the only point the movement component is read.
+	double StartTime = FPlatformTime::Seconds();
+	ScheduledTasks = 0;
+	if (Core) {
+		auto MoveComp = Core->GetMoveComp();
+		if (MoveComp) {
+			Core->CaptureMovementState(MoveComp, Snapshot);
+			ScheduledTasks = Core->__ScheduleTasks();
+		}
+	}
+	GameThreadSeconds = FPlatformTime::Seconds() - StartTime;
 }
 
-void UDDDAnimationCore::__ReplicateIdleTime(float dt) {
-	IdleTime = OwnerMoveComp->GetIdleTime();
+void FDDDAnimInstanceProxy::Update(float DeltaSeconds) {
+	FAnimInstanceProxy::Update(DeltaSeconds);
+
+	// Worker thread (when multi-threaded animation update is enabled).
+	if (Core && ScheduledTasks > 0) {
+		double StartTime = FPlatformTime::Seconds();
+		Core->__RunTasks(Snapshot, DeltaSeconds, ScheduledTasks, TaskState);
+		// Worker time doesn't count against the game thread budget.
+		if (IsInGameThread()) {
+			GameThreadSeconds += FPlatformTime::Seconds() - StartTime;
+		}
+	}
 }
 
-void UDDDAnimationCore::__ReplicateTurn(float dt) {
-	Turn = OwnerMoveComp->GetTurn();
+void FDDDAnimInstanceProxy::PostUpdate(UAnimInstance* InAnimInstance) const {
+	FAnimInstanceProxy::PostUpdate(InAnimInstance);
+
+	// Game thread, publish the task results.
+	double StartTime = FPlatformTime::Seconds();
+	if (Core && ScheduledTasks > 0) {
+		Core->__ApplyOutput(TaskState.Output);
+	}
+	double ApplySeconds = FPlatformTime::Seconds() - StartTime;
+
+	// Report the game thread cost to the budget.
+	if (Core && Core->BudgetMode && ScheduledTasks > 0) {
+		auto Budget = Core->GetWorld()->GetSubsystem<UDDDAnimationBudget>();
+		if (Budget) {
+			Budget->ReportCost(ScheduledTasks, GameThreadSeconds + ApplySeconds);
+		}
+	}
 }
@@ -0,0 +1,68 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "DDDAnimationBudget.generated.h"
+
+class UDDDAnimationCore;
+
+/*
+* Per instance bookkeeping for the budget.
+*/
+struct FDDDAnimationBudgetEntry {
+	TWeakObjectPtr<UDDDAnimationCore> Instance;
+
+	// How important the instance is this frame. Higher is updated first.
+	float Significance;
+
+	// Frames since the instance last received any budget. Prevents distant instances from starving.
+	int32 FramesSinceUpdate;
+
+	// Tasks the instance may run on its next update.
+	int32 TaskBudget;
+};
+
+/*
+* Ranks every budgeted UDDDAnimationCore by significance (player owned, visibility, distance to the local view)
+* and hands out a per-frame task budget derived from a game thread budget in milliseconds (pcpp.Anim.BudgetMs).
+* Near / important characters update every frame, distant ones update rarely.
+*/
+UCLASS()
+class PCPP_ANIMATION_API UDDDAnimationBudget : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+protected:
+	TArray<FDDDAnimationBudgetEntry> Entries;
+
+	// TaskBudget of every entry by instance, entries are reordered every frame.
+	TMap<TWeakObjectPtr<UDDDAnimationCore>, int32> TaskBudgets;
+
+	// Running average game thread cost of a single task in milliseconds. (Snapshot, applying the output and any update that isn't on a worker)
+	float AverageTaskCostMs;
+
+	// Computes significance for an instance relative to the local view.
+	float ComputeSignificance(UDDDAnimationCore* Instance, const FVector& ViewLocation, bool HasView);
+
+public:
+	UDDDAnimationBudget();
+
+	void Register(UDDDAnimationCore* Instance);
+
+	void Unregister(UDDDAnimationCore* Instance);
+
+	// Tasks the instance may run this frame.
+	int32 GetTaskBudget(UDDDAnimationCore* Instance);
+
+	// Reported by instances after running tasks so the cost estimate tracks reality. Seconds is game thread time only.
+	void ReportCost(int32 TasksRun, double Seconds);
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual ETickableTickType GetTickableTickType() const override { return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional; }
+};
@@ -4,9 +4,82 @@
 
 #include "CoreMinimal.h"
 #include "Animation/AnimInstance.h"
+#include "Animation/AnimInstanceProxy.h"
 #include "DDDCharacterMovement.h"
 #include "DDDAnimationCore.generated.h"
 
+class UDDDAnimationCore;
+
+/*
+* Copy of the DDD Movement state taken on the game thread. Tasks only read from this.
+*/
+struct FDDDMovementSnapshot {
+	EDDDMovementMode MovementMode = EDDDMovementMode::DDD_Walk;
+	float Speed = 0.f;
+	float AimPitch = 0.f;
+	float AimYaw = 0.f;
+	float IdleTime = 0.f;
+	float Turn = 0.f;
+
+	// EDDDDirty bits for the fields that were updated by the last capture.
+	uint8 DirtyMask = EDDDDirty::All;
+};
+
+/*
+* Results of the tasks. Written on the worker thread and copied onto UDDDAnimationCore in PostUpdate (game thread).
+*/
+struct FDDDAnimationOutput {
+	EDDDMovementMode MovementMode = EDDDMovementMode::DDD_Walk;
+	float Speed = 0.f;
+	float AimPitch = 0.f;
+	float AimYaw = 0.f;
+	float IdleTime = 0.f;
+	float Turn = 0.f;
+};
+
+/*
+* Task scheduling state carried between updates, only touched by the worker.
+*/
+struct FDDDTaskState {
+	// The index of the task being run.
+	int32 TaskIndex = 0;
+
+	// Time accumulated per task since it last ran. Used to correct dt when the budget or dirty flags decide which tasks run.
+	TArray<float> TaskTimeAccumulated;
+
+	FDDDAnimationOutput Output;
+};
+
+/*
+* Copies the DDD Movement state in PreUpdate (game thread) and runs the UDDDAnimationCore Tasks in Update (worker thread).
+* Task results stay in the proxy until PostUpdate, the UObject is never written off the game thread.
+*/
+USTRUCT()
+struct PCPP_ANIMATION_API FDDDAnimInstanceProxy : public FAnimInstanceProxy
+{
+	GENERATED_BODY()
+
+	FDDDAnimInstanceProxy() : Core(nullptr), ScheduledTasks(0), GameThreadSeconds(0.0) {}
+	FDDDAnimInstanceProxy(UAnimInstance* InAnimInstance);
+
+protected:
+	UDDDAnimationCore* Core;
+
+	FDDDMovementSnapshot Snapshot;
+
+	FDDDTaskState TaskState;
+
+	// How many tasks Update should run, decided on the game thread.
+	int32 ScheduledTasks;
+
+	// Game thread time of this update so far (PreUpdate, plus Update when it isn't on a worker), reported in PostUpdate.
+	double GameThreadSeconds;
+
+	virtual void PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds) override;
+	virtual void Update(float DeltaSeconds) override;
+	virtual void PostUpdate(UAnimInstance* InAnimInstance) const override;
+};
+
 /**
  * Hooks into existing DDD Movement Component and tracks relevant data.
  */
@@ -14,33 +87,59 @@ UCLASS(BlueprintType)
 class PCPP_ANIMATION_API UDDDAnimationCore : public UAnimInstance
 {
 	GENERATED_BODY()
-	private:
-		typedef  void (UDDDAnimationCore::*TaskPtr)(float);
 
-		// The index of the task being run.
-		int32 TaskIndex;
+	friend struct FDDDAnimInstanceProxy;
 
-		void NextTask();
+	private:
+		/*
+		* Tasks run on an animation worker thread. They may only read the snapshot and write to the output.
+		*/
+		typedef  void (UDDDAnimationCore::*TaskPtr)(const FDDDMovementSnapshot&, float, FDDDAnimationOutput&) const;
+
+		void NextTask(FDDDTaskState& State) const;
 
 		UDDDCharacterMovement* OwnerMoveComp;
 
-		FORCEINLINE float TaskTimeElapsed(float dt) { return RoundRobinMode ? (Tasks.Num()*dt)/BatchSize : dt ; };
+		FORCEINLINE float TaskTimeElapsed(float dt) const { return RoundRobinMode ? (Tasks.Num()*dt)/BatchSize : dt ; };
+
+		// Change stamp (UDDDCharacterMovement::GetChangeStamp) of the last capture in DirtyMode.
+		uint64 LastCapturedStamp;
+
+		// The EDDDDirty bits a task depends on. Tasks without an entry always run.
+		FORCEINLINE uint8 __TaskMask(int32 Index) const { return TaskDirtyMasks.IsValidIndex(Index) ? TaskDirtyMasks[Index] : (uint8)EDDDDirty::All; };
 
-		void __OnCrouch();
-		void __OnWalk();
-		void __OnRun();
-		void __OnDead();
+		// How many tasks to run this frame. Game thread.
+		int32 __ScheduleTasks();
+
+		// Runs the scheduled amount of tasks against the snapshot into the proxy's state. Worker thread.
+		void __RunTasks(const FDDDMovementSnapshot& Snapshot, float dt, int32 TaskCount, FDDDTaskState& State) const;
+
+		// Copies the task results onto the properties. Game thread.
+		void __ApplyOutput(const FDDDAnimationOutput& Output);
 
 		// Realized after the fact that these don't actually need dt, but perhaps extended tasks will require it so I'll leave it in.
-		void __ReplicateSpeed(float dt);
-		void __ReplicateAim(float dt);
-		void __ReplicateIdleTime(float dt);
-		void __ReplicateTurn(float dt);
+		void __ReplicateSpeed(const FDDDMovementSnapshot& Snapshot, float dt, FDDDAnimationOutput& Out) const;
+		void __ReplicateAim(const FDDDMovementSnapshot& Snapshot, float dt, FDDDAnimationOutput& Out) const;
+		void __ReplicateIdleTime(const FDDDMovementSnapshot& Snapshot, float dt, FDDDAnimationOutput& Out) const;
+		void __ReplicateTurn(const FDDDMovementSnapshot& Snapshot, float dt, FDDDAnimationOutput& Out) const;
 
 	protected:
 		// Contains the Tasks located within the component. More specialized animation blueprints can add in extra tasks.
 		TArray<TaskPtr> Tasks;
 
+		// Parallel to Tasks, the EDDDDirty bits each task depends on. Only used in DirtyMode.
+		TArray<uint8> TaskDirtyMasks;
+
+		/*
+		* Copies the movement state on the game thread before the worker update.
+		* Specialized instances can override this to copy anything extra their tasks need into their own members.
+		*/
+		virtual void CaptureMovementState(UDDDCharacterMovement* MoveComp, FDDDMovementSnapshot& Out);
+
+		virtual FAnimInstanceProxy* CreateAnimInstanceProxy() override;
+
+		virtual void DestroyAnimInstanceProxy(FAnimInstanceProxy* InProxy) override;
+
 		/*
 		* Whether to run the Task updates in Round-Robin mode. 
 		*/
@@ -51,6 +150,20 @@ class PCPP_ANIMATION_API UDDDAnimationCore : public UAnimInstance
 		UPROPERTY(EditAnywhere)
 		int32 BatchSize;
 
+		/*
+		* Whether the amount of tasks run per frame is decided by UDDDAnimationBudget based on significance.
+		* Takes priority over RoundRobinMode.
+		*/
+		UPROPERTY(EditAnywhere)
+		bool BudgetMode;
+
+		/*
+		* Whether to copy only the properties the movement component marked dirty and run only the tasks depending on them.
+		* Takes priority over RoundRobinMode.
+		*/
+		UPROPERTY(EditAnywhere)
+		bool DirtyMode;
+
 		UPROPERTY(BlueprintReadOnly)
 		EDDDMovementMode MovementMode;
 
@@ -72,7 +185,13 @@ class PCPP_ANIMATION_API UDDDAnimationCore : public UAnimInstance
 	public:
 		UDDDAnimationCore();
 
-		virtual void NativeUpdateAnimation(float dt) override;
+		virtual void NativeInitializeAnimation() override;
+
+		virtual void NativeUninitializeAnimation() override;
+
+
+		// How many tasks make up a full update.
+		FORCEINLINE int32 GetTaskCount() const { return Tasks.Num(); };
 
 		// Provides the MoveComp and fetches it if not yet defined.
 		UFUNCTION(BlueprintPure)
@@ -19,5 +19,8 @@ public class PCPP_Components : ModuleRules {
         PrivateDependencyModuleNames.AddRange(new string[] {
 			
         });
+
+        // Preset dictionaries of FNetCompression.
+        AddEngineThirdPartyPrivateStaticDependencies(Target, "zlib");
     }
 }
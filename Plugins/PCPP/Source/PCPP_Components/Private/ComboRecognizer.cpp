@@ -0,0 +1,194 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ComboRecognizer.h"
+#include "Engine/World.h"
+#include "PCPP_UE4.h"
+
+UComboRecognizer::UComboRecognizer() {
+	PrimaryComponentTick.bCanEverTick = false;
+	ResetOnMatch = true;
+	NumSymbols = 0;
+	Current = 0;
+	HistoryHead = 0;
+	HistoryCount = 0;
+	Broadcaster = nullptr;
+}
+
+void UComboRecognizer::BeginPlay() {
+	Super::BeginPlay();
+	Compile();
+	if (PCPP_UE4::LazyGetComp(GetOwner(), Broadcaster)) {
+		BroadcasterHandle = Broadcaster->OnAnyInput.AddUObject(this, &UComboRecognizer::OnBroadcasterInput);
+	}
+}
+
+void UComboRecognizer::EndPlay(const EEndPlayReason::Type EndPlayReason) {
+	if (Broadcaster && BroadcasterHandle.IsValid()) {
+		Broadcaster->OnAnyInput.Remove(BroadcasterHandle);
+	}
+	Super::EndPlay(EndPlayReason);
+}
+
+void UComboRecognizer::OnBroadcasterInput(uint8 Input, EInputBroadcastState State, float Magnitude) {
+	Feed(Input, State, GetWorld() ? GetWorld()->GetTimeSeconds() : 0.f);
+}
+
+int32 UComboRecognizer::AddNode() {
+	int32 Node = NodeMaxDelay.Add(0.f);
+	Transitions.AddUninitialized(NumSymbols);
+	for (int32 i = 0; i < NumSymbols; ++i) {
+		Transitions[Node * NumSymbols + i] = INDEX_NONE;
+	}
+	return Node;
+}
+
+void UComboRecognizer::Compile() {
+	// Alphabet, only as many inputs as the patterns use.
+	int32 NumInputs = 0;
+	for (auto It = Patterns.CreateConstIterator(); It; ++It) {
+		for (auto Step = It->Steps.CreateConstIterator(); Step; ++Step) {
+			NumInputs = FMath::Max(NumInputs, (int32)Step->Input + 1);
+		}
+	}
+	NumSymbols = NumInputs * StatesPerInput;
+	UsedSymbols.Init(false, NumSymbols);
+
+	Transitions.Reset();
+	NodeMaxDelay.Reset();
+	TArray<TArray<int32>> NodeOutputs;
+	AddNode();
+	NodeOutputs.AddDefaulted();
+
+	// Trie of every pattern.
+	for (int32 p = 0; p < Patterns.Num(); ++p) {
+		const auto& Steps = Patterns[p].Steps;
+		bool Valid = Steps.Num() > 0 && Steps.Num() <= MaxSteps;
+		for (auto Step = Steps.CreateConstIterator(); Step && Valid; ++Step) {
+			Valid = (Step->State != EInputBroadcastState::Held);
+		}
+		if (!Valid) {
+			UE_LOG(LogTemp, Warning, TEXT("UComboRecognizer: Skipping combo %s, it must have 1-%d steps without Held."), *Patterns[p].Name.ToString(), MaxSteps);
+			continue;
+		}
+
+		int32 Node = 0;
+		for (int32 s = 0; s < Steps.Num(); ++s) {
+			int32 Sym = Symbol((uint8)Steps[s].Input, Steps[s].State);
+			UsedSymbols[Sym] = true;
+			if (s > 0) {
+				NodeMaxDelay[Node] = FMath::Max(NodeMaxDelay[Node], Steps[s].MaxDelay);
+			}
+			int32 Index = Node * NumSymbols + Sym;
+			if (Transitions[Index] == INDEX_NONE) {
+				int32 Child = AddNode();
+				NodeOutputs.AddDefaulted();
+				Transitions[Index] = Child;
+			}
+			Node = Transitions[Index];
+		}
+		NodeOutputs[Node].Add(p);
+	}
+	// The start state never times out.
+	NodeMaxDelay[0] = BIG_NUMBER;
+
+	// Failure links (breadth first so that shorter suffixes are complete first), filling in the missing transitions.
+	TArray<int32> Fail;
+	Fail.Init(0, NodeMaxDelay.Num());
+	TArray<int32> Queue;
+	Queue.Reserve(NodeMaxDelay.Num());
+	for (int32 Sym = 0; Sym < NumSymbols; ++Sym) {
+		int32& Child = Transitions[Sym];
+		if (Child == INDEX_NONE) {
+			Child = 0;
+		} else {
+			Queue.Add(Child);
+		}
+	}
+	for (int32 i = 0; i < Queue.Num(); ++i) {
+		int32 Node = Queue[i];
+		if (Fail[Node] != 0) {
+			// Patterns ending in a suffix also end here, and a suffix may still be extended.
+			NodeOutputs[Node].Append(NodeOutputs[Fail[Node]]);
+			NodeMaxDelay[Node] = FMath::Max(NodeMaxDelay[Node], NodeMaxDelay[Fail[Node]]);
+		}
+		for (int32 Sym = 0; Sym < NumSymbols; ++Sym) {
+			int32 Index = Node * NumSymbols + Sym;
+			int32 FailTransition = Transitions[Fail[Node] * NumSymbols + Sym];
+			if (Transitions[Index] == INDEX_NONE) {
+				Transitions[Index] = FailTransition;
+			} else {
+				Fail[Transitions[Index]] = FailTransition;
+				Queue.Add(Transitions[Index]);
+			}
+		}
+	}
+
+	// Flatten the outputs.
+	OutputStart.SetNum(NodeOutputs.Num());
+	OutputCount.SetNum(NodeOutputs.Num());
+	Outputs.Reset();
+	for (int32 Node = 0; Node < NodeOutputs.Num(); ++Node) {
+		OutputStart[Node] = Outputs.Num();
+		OutputCount[Node] = NodeOutputs[Node].Num();
+		Outputs.Append(NodeOutputs[Node]);
+	}
+
+	Reset();
+}
+
+void UComboRecognizer::Reset() {
+	Current = 0;
+	HistoryHead = 0;
+	HistoryCount = 0;
+}
+
+void UComboRecognizer::Feed(uint8 Input, EInputBroadcastState State, float Time) {
+	if (State == EInputBroadcastState::Held) {
+		return;
+	}
+	// Unused events neither break a combo nor take a place in the history.
+	int32 Sym = Symbol(Input, State);
+	if (Sym >= UsedSymbols.Num() || !UsedSymbols[Sym]) {
+		return;
+	}
+
+	// Too late for anything leaving the current state.
+	if (Current != 0 && HistoryCount > 0 && Time - HistoryAt(0) > NodeMaxDelay[Current]) {
+		Current = 0;
+	}
+	Current = Transitions[Current * NumSymbols + Sym];
+
+	History[HistoryHead] = Time;
+	HistoryHead = (HistoryHead + 1) % MaxSteps;
+	HistoryCount = FMath::Min(HistoryCount + 1, (int32)MaxSteps);
+
+	bool Matched = false;
+	for (int32 i = OutputStart[Current], End = i + OutputCount[Current]; i < End; ++i) {
+		int32 PatternIndex = Outputs[i];
+		if (MatchesTiming(Patterns[PatternIndex])) {
+			Matched = true;
+			OnComboMatchedNative.Broadcast(PatternIndex);
+			OnComboMatched.Broadcast(Patterns[PatternIndex].Name);
+		}
+	}
+
+	if (Matched && ResetOnMatch) {
+		Current = 0;
+	}
+}
+
+bool UComboRecognizer::MatchesTiming(const FComboPattern& Pattern) const {
+	int32 Num = Pattern.Steps.Num();
+	if (Num > HistoryCount) {
+		return false;
+	}
+	// The last Num events are the pattern's steps, oldest at Num - 1.
+	for (int32 s = 1; s < Num; ++s) {
+		float Gap = HistoryAt(Num - 1 - s) - HistoryAt(Num - s);
+		if (Gap > Pattern.Steps[s].MaxDelay) {
+			return false;
+		}
+	}
+	return true;
+}
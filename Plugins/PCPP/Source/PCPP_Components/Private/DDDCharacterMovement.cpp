@@ -2,7 +2,14 @@
 
 
 #include "DDDCharacterMovement.h"
+#include "DDDMovementBatcher.h"
 #include "Kismet/KismetMathLibrary.h"
+#include "GameFramework/Character.h"
+
+uint64 UDDDCharacterMovement::ChangeCounter = 0;
+
+// Seconds a traced input may go without being applied before it is dropped, ie: a buffered action that expired.
+static const double DDDMaxInputTraceSeconds = 1.0;
 
 UDDDCharacterMovement::UDDDCharacterMovement() {
 	Config.MoveSpeed = 200.f;
@@ -10,6 +17,21 @@ UDDDCharacterMovement::UDDDCharacterMovement() {
 	Config.CrouchMultiplier = 0.5;
 	Config.LockOnDead = true;
 	Config.AimSpeed = 15.f;
+	Config.UseBatchedUpdate = false;
+	Config.SleepThreshold = 1.f;
+	Sleeping = false;
+	SteadyTime = 0.f;
+	HasPendingInput = false;
+	IdleStartTime = 0.f;
+	Batched = false;
+	PublishedSpeed = 0.f;
+	PublishedAimPitch = 0.f;
+	PublishedAimYaw = 0.f;
+	PublishedIdleTime = 0.f;
+	PublishedTurn = 0.f;
+	for (auto i = 0; i < EDDDDirty::Count; ++i) {
+		ChangedStamp[i] = 0;
+	}
 }
 
 void UDDDCharacterMovement::SetDDDMovementMode(EDDDMovementMode NewMovementMode){
@@ -21,6 +43,8 @@ void UDDDCharacterMovement::SetDDDMovementMode(EDDDMovementMode NewMovementMode)
 	// Update if needed then call relevant delegate.
 	if (DDDMovementMode != NewMovementMode) {
 		DDDMovementMode = NewMovementMode;
+		__MarkDirty(EDDDDirty::Mode);
+		MarkInputTrace(EInputLatencyStage::ModeChange);
 		switch (DDDMovementMode) {
 			case EDDDMovementMode::DDD_Walk:
 				OnWalk.Broadcast();
@@ -38,8 +62,44 @@ void UDDDCharacterMovement::SetDDDMovementMode(EDDDMovementMode NewMovementMode)
 	}
 }
 
+void UDDDCharacterMovement::TraceInput(uint8 Input) {
+	FInputLatency::Begin(LatencyTrace, Input);
+}
+
+void UDDDCharacterMovement::MarkInputTrace(EInputLatencyStage Stage) {
+	if (LatencyTrace.Active) {
+		FInputLatency::Mark(LatencyTrace, Stage);
+	}
+}
+
+bool UDDDCharacterMovement::CanApplyNetworkedMode(EDDDMovementMode NewMovementMode) {
+	// Death is server authoritative so it cannot be requested or left by a client move.
+	return NewMovementMode != EDDDMovementMode::DDD_Dead && GetDDDMovementMode() != EDDDMovementMode::DDD_Dead;
+}
+
+FNetworkPredictionData_Client* UDDDCharacterMovement::GetPredictionData_Client() const {
+	if (!ClientPredictionData) {
+		UDDDCharacterMovement* MutableThis = const_cast<UDDDCharacterMovement*>(this);
+		MutableThis->ClientPredictionData = new FNetworkPredictionData_Client_DDD(*this);
+	}
+	return ClientPredictionData;
+}
+
+void UDDDCharacterMovement::UpdateFromCompressedFlags(uint8 Flags) {
+	Super::UpdateFromCompressedFlags(Flags);
+
+	// Server side, apply the mode the client predicted with.
+	auto NewMovementMode = FSavedMove_DDD::DecodeMode(Flags);
+	if (CanApplyNetworkedMode(NewMovementMode)) {
+		SetDDDMovementMode(NewMovementMode);
+	}
+}
+
 void UDDDCharacterMovement::SetTargetLocation(FVector NewTargetLocation)
 {
+	if (!TargetLocation.Equals(NewTargetLocation)) {
+		__Wake();
+	}
 	TargetLocation = NewTargetLocation;
 }
 
@@ -65,9 +125,64 @@ float UDDDCharacterMovement::GetTurn()
 
 float UDDDCharacterMovement::GetIdleTime()
 {
+	// Idle time is analytic while asleep.
+	if (Sleeping) {
+		return GetWorld()->GetTimeSeconds() - IdleStartTime;
+	}
 	return IdleTime;
 }
 
+uint8 UDDDCharacterMovement::GetDirtySince(uint64 Stamp) const
+{
+	uint8 Mask = 0;
+	for (auto i = 0; i < EDDDDirty::Count; ++i) {
+		if (ChangedStamp[i] > Stamp) {
+			Mask |= (1 << i);
+		}
+	}
+	return Mask;
+}
+
+void UDDDCharacterMovement::__MarkDirty(uint8 Mask)
+{
+	if (Mask == 0) {
+		return;
+	}
+	ChangeCounter++;
+	for (auto i = 0; i < EDDDDirty::Count; ++i) {
+		if (Mask & (1 << i)) {
+			ChangedStamp[i] = ChangeCounter;
+		}
+	}
+}
+
+void UDDDCharacterMovement::__Publish()
+{
+	uint8 Mask = 0;
+
+	float CurrentSpeed = GetSpeed();
+	if (CurrentSpeed != PublishedSpeed) {
+		PublishedSpeed = CurrentSpeed;
+		Mask |= EDDDDirty::Speed;
+	}
+	if (CurrentAimPitch != PublishedAimPitch || CurrentAimYaw != PublishedAimYaw) {
+		PublishedAimPitch = CurrentAimPitch;
+		PublishedAimYaw = CurrentAimYaw;
+		Mask |= EDDDDirty::Aim;
+	}
+	float CurrentIdleTime = GetIdleTime();
+	if (CurrentIdleTime != PublishedIdleTime) {
+		PublishedIdleTime = CurrentIdleTime;
+		Mask |= EDDDDirty::IdleTime;
+	}
+	if (Turn != PublishedTurn) {
+		PublishedTurn = Turn;
+		Mask |= EDDDDirty::Turn;
+	}
+
+	__MarkDirty(Mask);
+}
+
 void UDDDCharacterMovement::OnComponentCreated() {
 	Super::OnComponentCreated();
 
@@ -87,6 +202,30 @@ void UDDDCharacterMovement::OnComponentCreated() {
 	MoveInterrupted.AddDynamic(this, &UDDDCharacterMovement::__OnInterrupt);
 }
 
+void UDDDCharacterMovement::BeginPlay() {
+	Super::BeginPlay();
+
+	// Hand bookkeeping to the batcher. The tick is still needed for movement itself.
+	if (Config.UseBatchedUpdate) {
+		auto Batcher = GetWorld()->GetSubsystem<UDDDMovementBatcher>();
+		if (Batcher) {
+			Batcher->Register(this);
+			Batched = true;
+		}
+	}
+}
+
+void UDDDCharacterMovement::EndPlay(const EEndPlayReason::Type EndPlayReason) {
+	if (Batched) {
+		auto Batcher = GetWorld()->GetSubsystem<UDDDMovementBatcher>();
+		if (Batcher) {
+			Batcher->Unregister(this);
+		}
+		Batched = false;
+	}
+	Super::EndPlay(EndPlayReason);
+}
+
 void UDDDCharacterMovement::__OnWalk()
 {
 	MaxWalkSpeed = Config.MoveSpeed;
@@ -109,6 +248,7 @@ void UDDDCharacterMovement::__OnDead()
 
 void UDDDCharacterMovement::__OnInterrupt()
 {
+	__Wake();
 	IdleTime = 0.f;
 }
 
@@ -139,14 +279,158 @@ void UDDDCharacterMovement::__TrackTurn()
 	Turn = UKismetMathLibrary::NormalizedDeltaRotator(OldRotation, PreviousActorRotation).Yaw;
 }
 
-void UDDDCharacterMovement::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction * ThisTickFunction)
+bool UDDDCharacterMovement::__UpdateSleep(float DeltaTime)
 {
-	// If owner moves then reset idle time.
-	if (GetSpeed() == 0.f && GetTurn() == 0.f) {
-		IdleTime += DeltaTime;
+	auto Owner = GetOwner();
+	bool Moving = !Owner->GetVelocity().IsZero();
+	bool Turning = !Owner->GetActorRotation().Equals(PreviousActorRotation);
+	bool HasInput = HasPendingInput;
+
+	if (Sleeping) {
+		// Wake on anything that would change the bookkeeping.
+		bool Aiming = UseControlRotationForAiming && PawnOwner && !PawnOwner->GetControlRotation().Equals(SleepControlRotation);
+		if (Moving || Turning || HasInput || Aiming) {
+			__Wake();
+		}
+		return Sleeping;
+	}
+
+	if (Config.SleepThreshold <= 0.f) {
+		return false;
+	}
+
+	// Steady when nothing moves and the aim has settled on its target.
+	bool AimSettled = FMath::IsNearlyEqual(CurrentAimPitch, FinalAimPitch) && FMath::IsNearlyEqual(CurrentAimYaw, FinalAimYaw);
+	if (!Moving && !Turning && !HasInput && AimSettled && Turn == 0.f) {
+		SteadyTime += DeltaTime;
+		if (SteadyTime >= Config.SleepThreshold) {
+			__Sleep();
+		}
 	} else {
-		IdleTime = 0.f;
+		SteadyTime = 0.f;
+	}
+	return Sleeping;
+}
+
+void UDDDCharacterMovement::__Sleep()
+{
+	Sleeping = true;
+	IdleStartTime = GetWorld()->GetTimeSeconds() - IdleTime;
+	if (PawnOwner) {
+		SleepControlRotation = PawnOwner->GetControlRotation();
+	}
+}
+
+void UDDDCharacterMovement::__Wake()
+{
+	if (Sleeping) {
+		// Resume from the analytic idle time.
+		IdleTime = GetWorld()->GetTimeSeconds() - IdleStartTime;
+		Sleeping = false;
+	}
+	SteadyTime = 0.f;
+}
+
+void UDDDCharacterMovement::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction * ThisTickFunction)
+{
+	// The base tick consumes the input vector.
+	HasPendingInput = PawnOwner && !PawnOwner->GetPendingMovementInputVector().IsZero();
+
+	// Movement (and client prediction) is performed by the base component.
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	// The traced input is only applied once it moved the character, not while it waits in the UInputBuffer. (ie: dodge while falling)
+	if (LatencyTrace.Active) {
+		if (FInputLatency::IsApplied(LatencyTrace)) {
+			FInputLatency::End(LatencyTrace);
+		} else if (FPlatformTime::Seconds() - LatencyTrace.StartSeconds > DDDMaxInputTraceSeconds) {
+			FInputLatency::Drop(LatencyTrace);
+		}
+	}
+
+	// Bookkeeping is handled by UDDDMovementBatcher.
+	if (Batched) {
+		return;
+	}
+
+	// Nothing changes while in a steady state.
+	if (!__UpdateSleep(DeltaTime)) {
+		// If owner moves then reset idle time.
+		if (GetSpeed() == 0.f && GetTurn() == 0.f) {
+			IdleTime += DeltaTime;
+		} else {
+			IdleTime = 0.f;
+		}
+		__TrackTarget(DeltaTime);
+		__TrackTurn();
+	}
+
+	__Publish();
+}
+
+void FSavedMove_DDD::Clear() {
+	FSavedMove_Character::Clear();
+	SavedDDDMovementMode = EDDDMovementMode::DDD_Walk;
+}
+
+uint8 FSavedMove_DDD::GetCompressedFlags() const {
+	return FSavedMove_Character::GetCompressedFlags() | EncodeMode(SavedDDDMovementMode);
+}
+
+bool FSavedMove_DDD::CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const {
+	// Moves made in different DDD modes move at different speeds.
+	if (SavedDDDMovementMode != static_cast<FSavedMove_DDD*>(NewMove.Get())->SavedDDDMovementMode) {
+		return false;
 	}
-	__TrackTarget(DeltaTime);
-	__TrackTurn();
+	return FSavedMove_Character::CanCombineWith(NewMove, InCharacter, MaxDelta);
+}
+
+void FSavedMove_DDD::SetMoveFor(ACharacter* InCharacter, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData) {
+	FSavedMove_Character::SetMoveFor(InCharacter, InDeltaTime, NewAccel, ClientData);
+
+	auto MoveComp = Cast<UDDDCharacterMovement>(InCharacter->GetCharacterMovement());
+	if (MoveComp) {
+		SavedDDDMovementMode = MoveComp->GetDDDMovementMode();
+	}
+}
+
+void FSavedMove_DDD::PrepMoveFor(ACharacter* InCharacter) {
+	FSavedMove_Character::PrepMoveFor(InCharacter);
+
+	// Restore the mode the move was originally made with so replays after a correction match.
+	auto MoveComp = Cast<UDDDCharacterMovement>(InCharacter->GetCharacterMovement());
+	if (MoveComp && MoveComp->CanApplyNetworkedMode(SavedDDDMovementMode)) {
+		MoveComp->SetDDDMovementMode(SavedDDDMovementMode);
+	}
+}
+
+uint8 FSavedMove_DDD::EncodeMode(EDDDMovementMode Mode) {
+	uint8 Value = (uint8)Mode;
+	uint8 Flags = 0;
+	if (Value & 0x1) {
+		Flags |= FLAG_Custom_0;
+	}
+	if (Value & 0x2) {
+		Flags |= FLAG_Custom_1;
+	}
+	return Flags;
+}
+
+EDDDMovementMode FSavedMove_DDD::DecodeMode(uint8 Flags) {
+	uint8 Value = 0;
+	if (Flags & FLAG_Custom_0) {
+		Value |= 0x1;
+	}
+	if (Flags & FLAG_Custom_1) {
+		Value |= 0x2;
+	}
+	return (EDDDMovementMode)Value;
+}
+
+FNetworkPredictionData_Client_DDD::FNetworkPredictionData_Client_DDD(const UCharacterMovementComponent& ClientMovement)
+	: FNetworkPredictionData_Client_Character(ClientMovement) {
+}
+
+FSavedMovePtr FNetworkPredictionData_Client_DDD::AllocateNewMove() {
+	return FSavedMovePtr(new FSavedMove_DDD());
 }
@@ -14,6 +14,12 @@ UDDDDriver::UDDDDriver(){
 	PreviousRightTurnInput = 0.f;
 	LockInputSensitivity = 0.25;
 	OwnerCamera = nullptr;
+	InputBuffer = nullptr;
+	DodgeSystem = nullptr;
+	InputRecorder = nullptr;
+	ActionBufferWindow = 0.2f;
+	TracedMoveAxes[0] = 0.f;
+	TracedMoveAxes[1] = 0.f;
 	// ...
 }
 
@@ -31,12 +37,245 @@ UCameraComponent * UDDDDriver::GetOwnerCamera(){
 	return PCPP_UE4::LazyGetComp(GetOwner(), OwnerCamera);
 }
 
+UInputBuffer * UDDDDriver::GetInputBuffer(){
+	return PCPP_UE4::LazyGetComp(GetOwner(), InputBuffer);
+}
+
+UDodgeSystem * UDDDDriver::GetDodgeSystem(){
+	return PCPP_UE4::LazyGetComp(GetOwner(), DodgeSystem);
+}
+
+UInputRecorder * UDDDDriver::GetInputRecorder(){
+	return PCPP_UE4::LazyGetComp(GetOwner(), InputRecorder);
+}
+
 // Called when the game starts
 void UDDDDriver::BeginPlay(){
 	Super::BeginPlay();
 	GetMovementComponent();
 	GetCharacterOwner();
 	GetLockOnSystem();
+	GetDodgeSystem();
+	GetInputRecorder();
+
+	if (GetInputBuffer()) {
+		// Drain after the controller has processed input and before movement consumes the input vector.
+		// Pawns are usually possessed after BeginPlay, so the controller prerequisite follows possession.
+		if (GetCharacterOwner()) {
+			GetCharacterOwner()->ReceiveControllerChangedDelegate.AddDynamic(this, &UDDDDriver::OnControllerChanged);
+			OnControllerChanged(GetCharacterOwner(), nullptr, GetCharacterOwner()->GetController());
+		}
+		if (GetMovementComponent()) {
+			GetMovementComponent()->PrimaryComponentTick.AddPrerequisite(this, PrimaryComponentTick);
+		}
+	} else {
+		// Nothing to do per frame without a buffer.
+		SetComponentTickEnabled(false);
+	}
+}
+
+void UDDDDriver::EndPlay(const EEndPlayReason::Type EndPlayReason) {
+	if (GetCharacterOwner()) {
+		GetCharacterOwner()->ReceiveControllerChangedDelegate.RemoveDynamic(this, &UDDDDriver::OnControllerChanged);
+	}
+	Super::EndPlay(EndPlayReason);
+}
+
+void UDDDDriver::OnControllerChanged(APawn* Pawn, AController* OldController, AController* NewController) {
+	if (OldController) {
+		PrimaryComponentTick.RemovePrerequisite(OldController, OldController->PrimaryActorTick);
+	}
+	if (NewController) {
+		PrimaryComponentTick.AddPrerequisite(NewController, NewController->PrimaryActorTick);
+	}
+}
+
+void UDDDDriver::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction){
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	auto Buffer = GetInputBuffer();
+	if (!Buffer) {
+		return;
+	}
+
+	// Handle releases / toggles in the order they happened.
+	Buffer->Drain([&](const FBufferedInputEvent& Event) {
+		switch ((EDDDDriverInput)Event.Input) {
+			case EDDDDriverInput::Sprint:
+				if (Event.Type == EBufferedInputType::Released) {
+					// A press that never got to sprint shouldn't start sprinting after the release.
+					Buffer->ConsumeAction(Event.Input, ActionBufferWindow);
+					EndSprint();
+				}
+				break;
+			case EDDDDriverInput::Crouch:
+				if (Event.Type == EBufferedInputType::Pressed) {
+					ToggleCrouch();
+				}
+				break;
+			default:
+				break;
+		}
+	});
+
+	// Buffered actions, performed as soon as they are possible within the window.
+	if (CanSprint() && Buffer->ConsumeAction((uint8)EDDDDriverInput::Sprint, ActionBufferWindow)) {
+		BeginSprint();
+	}
+	if (CanDodge() && Buffer->ConsumeAction((uint8)EDDDDriverInput::Dodge, ActionBufferWindow)) {
+		Dodge();
+	}
+
+	ApplyMovement(
+		Buffer->GetAxis((uint8)EDDDDriverInput::MoveForward),
+		Buffer->GetAxis((uint8)EDDDDriverInput::MoveRight)
+	);
+}
+
+void UDDDDriver::ApplyMovement(float ForwardValue, float RightValue){
+	if ((ForwardValue == 0.f && RightValue == 0.f) || !GetMovementComponent() || !GetOwnerCamera()) {
+		return;
+	}
+	// Remove pitch bias so that the basis vectors are the correct length.
+	auto CameraRotation = GetOwnerCamera()->GetComponentRotation();
+	CameraRotation.Pitch = 0.f;
+	const FRotationMatrix Basis(CameraRotation);
+	GetMovementComponent()->AddInputVector(Basis.GetScaledAxis(EAxis::X) * ForwardValue + Basis.GetScaledAxis(EAxis::Y) * RightValue);
+	GetMovementComponent()->MarkInputTrace(EInputLatencyStage::InputVector);
+}
+
+bool UDDDDriver::CanSprint(){
+	return GetMovementComponent() && GetMovementComponent()->GetDDDMovementMode() != EDDDMovementMode::DDD_Dead;
+}
+
+bool UDDDDriver::CanDodge(){
+	return GetDodgeSystem() && GetMovementComponent() && !GetMovementComponent()->IsFalling() &&
+		GetMovementComponent()->GetDDDMovementMode() != EDDDMovementMode::DDD_Dead;
+}
+
+void UDDDDriver::__InputMoveForward(float AxisValue){
+	__OnInput(EDDDDriverInput::MoveForward, AxisValue);
+}
+
+void UDDDDriver::__InputMoveRight(float AxisValue){
+	__OnInput(EDDDDriverInput::MoveRight, AxisValue);
+}
+
+void UDDDDriver::__InputSprintPressed(){
+	__OnInput(EDDDDriverInput::Sprint, 1.f);
+}
+
+void UDDDDriver::__InputSprintReleased(){
+	__OnInput(EDDDDriverInput::Sprint, 0.f);
+}
+
+void UDDDDriver::__InputCrouch(){
+	__OnInput(EDDDDriverInput::Crouch, 1.f);
+}
+
+void UDDDDriver::__InputDodge(){
+	__OnInput(EDDDDriverInput::Dodge, 1.f);
+}
+
+void UDDDDriver::__InputTurnUp(float AxisValue){
+	__OnInput(EDDDDriverInput::TurnUp, AxisValue);
+}
+
+void UDDDDriver::__InputTurnRight(float AxisValue){
+	__OnInput(EDDDDriverInput::TurnRight, AxisValue);
+}
+
+void UDDDDriver::__OnInput(EDDDDriverInput Input, float Value){
+	if (GetInputRecorder()) {
+		// The replay owns the input, live input would break determinism.
+		if (InputRecorder->IsReplaying()) {
+			return;
+		}
+		InputRecorder->RecordDriverInput((uint8)Input, Value);
+	}
+	__HandleInput(Input, Value);
+}
+
+void UDDDDriver::InjectInput(uint8 Input, float Value){
+	if (Input < (uint8)EDDDDriverInput::MAX) {
+		__HandleInput((EDDDDriverInput)Input, Value);
+	}
+}
+
+void UDDDDriver::__TraceInput(EDDDDriverInput Input, float Value){
+	bool Starts = false;
+	switch (Input) {
+		case EDDDDriverInput::MoveForward:
+		case EDDDDriverInput::MoveRight:
+			Starts = (Value != 0.f && TracedMoveAxes[(uint8)Input] == 0.f);
+			TracedMoveAxes[(uint8)Input] = Value;
+			break;
+		case EDDDDriverInput::TurnUp:
+		case EDDDDriverInput::TurnRight:
+			break;
+		default:
+			// Releases aren't followed.
+			Starts = (Value != 0.f);
+			break;
+	}
+	if (Starts) {
+		GetMovementComponent()->TraceInput((uint8)Input);
+	}
+}
+
+void UDDDDriver::__HandleInput(EDDDDriverInput Input, float Value){
+	if (FInputLatency::IsEnabled() && GetMovementComponent()) {
+		__TraceInput(Input, Value);
+	}
+
+	auto Buffer = GetInputBuffer();
+	switch (Input) {
+		case EDDDDriverInput::MoveForward:
+			if (Buffer) {
+				Buffer->RecordAxis((uint8)Input, Value);
+			} else {
+				MoveForward(Value);
+			}
+			break;
+		case EDDDDriverInput::MoveRight:
+			if (Buffer) {
+				Buffer->RecordAxis((uint8)Input, Value);
+			} else {
+				MoveRight(Value);
+			}
+			break;
+		case EDDDDriverInput::Sprint:
+			if (Buffer) {
+				Buffer->RecordAction((uint8)Input, Value != 0.f);
+			} else if (Value != 0.f) {
+				BeginSprint();
+			} else {
+				EndSprint();
+			}
+			break;
+		case EDDDDriverInput::Crouch:
+			if (Buffer) {
+				Buffer->RecordAction((uint8)Input, true);
+			} else {
+				ToggleCrouch();
+			}
+			break;
+		case EDDDDriverInput::Dodge:
+			if (Buffer) {
+				Buffer->RecordAction((uint8)Input, true);
+			} else {
+				Dodge();
+			}
+			break;
+		case EDDDDriverInput::TurnUp:
+			TurnUp(Value);
+			break;
+		case EDDDDriverInput::TurnRight:
+			TurnRight(Value);
+			break;
+		default:
+			break;
+	}
 }
 
 void UDDDDriver::BindInputs(
@@ -46,29 +285,34 @@ void UDDDDriver::BindInputs(
 	FName Sprint,
 	FName Crouch,
 	FName UpTurnAxis,
-	FName RightTurnAxis) {
+	FName RightTurnAxis,
+	FName DodgeAction) {
 	// Bind set of movements to corresponding axis / input names.
 	if (InputComponent) { 
+		// Every binding goes through __OnInput (recording / buffering), see __HandleInput.
 		// Movement
 		if (ForwardMovementAxis != NAME_None) {
-			InputComponent->BindAxis(ForwardMovementAxis,this,&UDDDDriver::MoveForward);
+			InputComponent->BindAxis(ForwardMovementAxis, this, &UDDDDriver::__InputMoveForward);
 		}
 		if (RightMovementAxis != NAME_None) {
-			InputComponent->BindAxis(RightMovementAxis, this, &UDDDDriver::MoveRight);
+			InputComponent->BindAxis(RightMovementAxis, this, &UDDDDriver::__InputMoveRight);
 		}
 		if (Sprint != NAME_None) {
-			InputComponent->BindAction(Sprint, EInputEvent::IE_Pressed, this, &UDDDDriver::BeginSprint);
-			InputComponent->BindAction(Sprint, EInputEvent::IE_Released, this, &UDDDDriver::EndSprint);
+			InputComponent->BindAction(Sprint, EInputEvent::IE_Pressed, this, &UDDDDriver::__InputSprintPressed);
+			InputComponent->BindAction(Sprint, EInputEvent::IE_Released, this, &UDDDDriver::__InputSprintReleased);
 		}
 		if (Crouch != NAME_None) {
-			InputComponent->BindAction(Crouch, EInputEvent::IE_Pressed, this, &UDDDDriver::ToggleCrouch);
+			InputComponent->BindAction(Crouch, EInputEvent::IE_Pressed, this, &UDDDDriver::__InputCrouch);
+		}
+		if (DodgeAction != NAME_None) {
+			InputComponent->BindAction(DodgeAction, EInputEvent::IE_Pressed, this, &UDDDDriver::__InputDodge);
 		}
 		// Turning / Camera
 		if (UpTurnAxis != NAME_None) {
-			InputComponent->BindAxis(UpTurnAxis, this, &UDDDDriver::TurnUp);
+			InputComponent->BindAxis(UpTurnAxis, this, &UDDDDriver::__InputTurnUp);
 		}
 		if (RightTurnAxis != NAME_None) {
-			InputComponent->BindAxis(RightTurnAxis, this, &UDDDDriver::TurnRight);
+			InputComponent->BindAxis(RightTurnAxis, this, &UDDDDriver::__InputTurnRight);
 		}
 	}
 }
@@ -79,6 +323,9 @@ void UDDDDriver::MoveForward(float AxisValue){
 		// Remove pitch bias so that forward vector is correct length.
 		CameraRotation.Pitch = 0.f;
 		GetMovementComponent()->AddInputVector(UKismetMathLibrary::GetForwardVector(CameraRotation) * AxisValue);
+		if (AxisValue != 0.f) {
+			GetMovementComponent()->MarkInputTrace(EInputLatencyStage::InputVector);
+		}
 	}
 }
 
@@ -88,6 +335,9 @@ void UDDDDriver::MoveRight(float AxisValue){
 		// Remove pitch bias so that right vector is correct length.
 		CameraRotation.Pitch = 0.f;
 		GetMovementComponent()->AddInputVector(UKismetMathLibrary::GetRightVector(CameraRotation) * AxisValue);
+		if (AxisValue != 0.f) {
+			GetMovementComponent()->MarkInputTrace(EInputLatencyStage::InputVector);
+		}
 	}
 }
 
@@ -115,6 +365,12 @@ void UDDDDriver::ToggleCrouch(){
 	}
 }
 
+void UDDDDriver::Dodge(){
+	if (GetDodgeSystem()) {
+		GetDodgeSystem()->DodgeUsingInput();
+	}
+}
+
 void UDDDDriver::TurnRight(float AxisValue){
 	if (GetMovementComponent()) {
 		if (!LockedOn) {
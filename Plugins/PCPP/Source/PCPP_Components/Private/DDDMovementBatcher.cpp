@@ -0,0 +1,198 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DDDMovementBatcher.h"
+#include "DDDCharacterMovement.h"
+#include "Async/ParallelFor.h"
+#include "Engine/World.h"
+
+// Width of a vector packet.
+static const int32 DDDPacketWidth = 4;
+
+// Matches FRotator::NormalizeAxis for a single angle, wrapping into (-180, 180].
+FORCEINLINE static float _NormalizeAxis(float Angle) {
+	Angle = FMath::Fmod(Angle, 360.f);
+	if (Angle < 0.f) {
+		Angle += 360.f;
+	}
+	if (Angle > 180.f) {
+		Angle -= 360.f;
+	}
+	return Angle;
+}
+
+// Matches UKismetMathLibrary::FInterpTo.
+FORCEINLINE static float _InterpTo(float Current, float Target, float DeltaTime, float InterpSpeed) {
+	if (InterpSpeed <= 0.f) {
+		return Target;
+	}
+	const float Dist = Target - Current;
+	if (FMath::Square(Dist) < SMALL_NUMBER) {
+		return Target;
+	}
+	return Current + Dist * FMath::Clamp(DeltaTime * InterpSpeed, 0.f, 1.f);
+}
+
+void FDDDMovementBatch::SetNum(int32 Num) {
+	int32 Padded = Align(Num, DDDPacketWidth);
+	for (auto Array : { &LocationX, &LocationY, &LocationZ, &TargetX, &TargetY, &TargetZ, &ActorPitch, &ActorYaw,
+		&ControlPitch, &ControlYaw, &Speed, &AimSpeed, &PreviousYaw, &CurrentAimPitch, &CurrentAimYaw,
+		&FinalAimPitch, &FinalAimYaw, &Turn, &IdleTime }) {
+		Array->SetNumZeroed(Padded, false);
+	}
+	UseControlRotation.SetNumZeroed(Padded, false);
+	HasPawn.SetNumZeroed(Padded, false);
+}
+
+UDDDMovementBatcher::UDDDMovementBatcher() {
+	ParallelThreshold = 64;
+}
+
+void UDDDMovementBatcher::Register(UDDDCharacterMovement* Component) {
+	if (Component) {
+		Components.AddUnique(Component);
+	}
+}
+
+void UDDDMovementBatcher::Unregister(UDDDCharacterMovement* Component) {
+	Components.RemoveSwap(Component);
+}
+
+bool UDDDMovementBatcher::IsTickable() const {
+	return Components.Num() > 0;
+}
+
+TStatId UDDDMovementBatcher::GetStatId() const {
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UDDDMovementBatcher, STATGROUP_Tickables);
+}
+
+void UDDDMovementBatcher::Tick(float DeltaTime) {
+	// Drop anything that was destroyed without unregistering.
+	Components.RemoveAllSwap([](const TWeakObjectPtr<UDDDCharacterMovement>& Component) {
+		return !Component.IsValid() || !Component->GetOwner();
+	});
+
+	// Only awake components take part in the batch.
+	Active.Reset();
+	for (auto It = Components.CreateIterator(); It; ++It) {
+		auto Component = It->Get();
+		if (!Component->__UpdateSleep(DeltaTime)) {
+			Active.Add(Component);
+		}
+	}
+
+	Gather();
+	Process(DeltaTime);
+	Scatter();
+
+	// Nothing may hold on to the components between ticks.
+	Active.Reset();
+}
+
+void UDDDMovementBatcher::Gather() {
+	Batch.SetNum(Active.Num());
+	for (int32 i = 0; i < Active.Num(); ++i) {
+		auto Component = Active[i];
+		auto Owner = Component->GetOwner();
+		auto Location = Owner->GetActorLocation();
+		auto Rotation = Owner->GetActorRotation();
+
+		Batch.LocationX[i] = Location.X;
+		Batch.LocationY[i] = Location.Y;
+		Batch.LocationZ[i] = Location.Z;
+		Batch.TargetX[i] = Component->TargetLocation.X;
+		Batch.TargetY[i] = Component->TargetLocation.Y;
+		Batch.TargetZ[i] = Component->TargetLocation.Z;
+		Batch.ActorPitch[i] = Rotation.Pitch;
+		Batch.ActorYaw[i] = Rotation.Yaw;
+		Batch.Speed[i] = Owner->GetVelocity().Size();
+		Batch.AimSpeed[i] = Component->Config.AimSpeed;
+		Batch.PreviousYaw[i] = Component->PreviousActorRotation.Yaw;
+		Batch.UseControlRotation[i] = Component->UseControlRotationForAiming;
+		Batch.HasPawn[i] = (Component->PawnOwner != nullptr);
+		if (Component->PawnOwner && Component->UseControlRotationForAiming) {
+			auto ControlRotation = Component->PawnOwner->GetControlRotation();
+			Batch.ControlPitch[i] = ControlRotation.Pitch;
+			Batch.ControlYaw[i] = ControlRotation.Yaw;
+		}
+
+		Batch.CurrentAimPitch[i] = Component->CurrentAimPitch;
+		Batch.CurrentAimYaw[i] = Component->CurrentAimYaw;
+		Batch.FinalAimPitch[i] = Component->FinalAimPitch;
+		Batch.FinalAimYaw[i] = Component->FinalAimYaw;
+		Batch.Turn[i] = Component->Turn;
+		Batch.IdleTime[i] = Component->IdleTime;
+	}
+}
+
+void UDDDMovementBatcher::Process(float DeltaTime) {
+	int32 PacketCount = Batch.IdleTime.Num() / DDDPacketWidth;
+	FDDDMovementBatch& B = Batch;
+
+	auto ProcessPacket = [&B, DeltaTime](int32 Packet) {
+		const int32 First = Packet * DDDPacketWidth;
+
+		// Look at angles for the whole packet. (FVector::Rotation for Target - Location.)
+		VectorRegister DX = VectorSubtract(VectorLoad(&B.TargetX[First]), VectorLoad(&B.LocationX[First]));
+		VectorRegister DY = VectorSubtract(VectorLoad(&B.TargetY[First]), VectorLoad(&B.LocationY[First]));
+		VectorRegister DZ = VectorSubtract(VectorLoad(&B.TargetZ[First]), VectorLoad(&B.LocationZ[First]));
+		VectorRegister DXY = VectorMultiplyAdd(DX, DX, VectorMultiply(DY, DY));
+		DXY = VectorMultiply(DXY, VectorReciprocalSqrt(VectorMax(DXY, VectorSetFloat1(SMALL_NUMBER))));
+		VectorRegister RadToDeg = VectorSetFloat1(180.f / PI);
+		VectorRegister LookYaw = VectorMultiply(VectorATan2(DY, DX), RadToDeg);
+		VectorRegister LookPitch = VectorMultiply(VectorATan2(DZ, DXY), RadToDeg);
+
+		float LookYawOut[DDDPacketWidth];
+		float LookPitchOut[DDDPacketWidth];
+		VectorStore(LookYaw, LookYawOut);
+		VectorStore(LookPitch, LookPitchOut);
+
+		for (int32 Lane = 0; Lane < DDDPacketWidth; ++Lane) {
+			const int32 i = First + Lane;
+
+			// Idle check uses last frame's turn, as in UDDDCharacterMovement::TickComponent.
+			if (B.Speed[i] == 0.f && B.Turn[i] == 0.f) {
+				B.IdleTime[i] += DeltaTime;
+			} else {
+				B.IdleTime[i] = 0.f;
+			}
+
+			// Aim
+			if (B.HasPawn[i]) {
+				if (B.UseControlRotation[i]) {
+					B.FinalAimPitch[i] = FMath::Clamp(B.ControlPitch[i], -45.f, 45.f);
+					B.FinalAimYaw[i] = FMath::Clamp(B.ControlYaw[i], -45.f, 45.f);
+				} else {
+					B.FinalAimPitch[i] = FMath::Clamp(_NormalizeAxis(LookPitchOut[Lane] - B.ActorPitch[i]), -45.f, 45.f);
+					B.FinalAimYaw[i] = FMath::Clamp(_NormalizeAxis(LookYawOut[Lane] - B.ActorYaw[i]), -45.f, 45.f);
+				}
+				B.CurrentAimPitch[i] = _InterpTo(B.CurrentAimPitch[i], B.FinalAimPitch[i], DeltaTime, B.AimSpeed[i]);
+				B.CurrentAimYaw[i] = _InterpTo(B.CurrentAimYaw[i], B.FinalAimYaw[i], DeltaTime, B.AimSpeed[i]);
+			}
+
+			// Turn
+			B.Turn[i] = _NormalizeAxis(B.PreviousYaw[i] - B.ActorYaw[i]);
+		}
+	};
+
+	// Small batches aren't worth the overhead of waking worker threads.
+	ParallelFor(PacketCount, ProcessPacket, Active.Num() < ParallelThreshold);
+}
+
+void UDDDMovementBatcher::Scatter() {
+	for (int32 i = 0; i < Active.Num(); ++i) {
+		auto Component = Active[i];
+		Component->CurrentAimPitch = Batch.CurrentAimPitch[i];
+		Component->CurrentAimYaw = Batch.CurrentAimYaw[i];
+		Component->FinalAimPitch = Batch.FinalAimPitch[i];
+		Component->FinalAimYaw = Batch.FinalAimYaw[i];
+		Component->Turn = Batch.Turn[i];
+		Component->IdleTime = Batch.IdleTime[i];
+		Component->PreviousActorRotation = FRotator(Batch.ActorPitch[i], Batch.ActorYaw[i], Component->PreviousActorRotation.Roll);
+	}
+
+	// Sleeping components still publish, their idle time keeps advancing.
+	for (auto It = Components.CreateIterator(); It; ++It) {
+		(*It)->__Publish();
+	}
+}
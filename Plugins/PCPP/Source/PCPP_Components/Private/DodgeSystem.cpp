@@ -4,6 +4,7 @@
 #include "DodgeSystem.h"
 #include "GameFramework/Character.h"
 #include "LockOnSystem.h"
+#include "DDDCharacterMovement.h"
 #include "Kismet/KismetMathLibrary.h"
 #include "PCPP_UE4.h"
 
@@ -59,6 +60,11 @@ void UDodgeSystem::DodgeInDirection(FVector DodgeDirection)
 		}
 
 		Owner->LaunchCharacter(OwnerInput*DodgeStrength, true, false);
+
+		auto MoveComp = Cast<UDDDCharacterMovement>(Owner->GetCharacterMovement());
+		if (MoveComp) {
+			MoveComp->MarkInputTrace(EInputLatencyStage::Launch);
+		}
 	}
 }
 
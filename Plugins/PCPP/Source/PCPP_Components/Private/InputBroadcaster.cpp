@@ -2,13 +2,53 @@
 
 
 #include "InputBroadcaster.h"
+#include "InputLatency.h"
 
 UInputBroadcaster::UInputBroadcaster() {
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	// After the controller has processed input.
+	PrimaryComponentTick.TickGroup = ETickingGroup::TG_PostPhysics;
+	Queued = false;
+	AutoDispatch = true;
 	PrepareInputList(uint8(EDefaultInputLayout::MAX));
 }
 
+void UInputBroadcaster::BeginPlay() {
+	Super::BeginPlay();
+	_UpdateTickEnabled();
+}
+
+void UInputBroadcaster::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) {
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	ProcessQueue();
+	// Queued / AutoDispatch may have been cleared directly.
+	if (!(Queued && AutoDispatch)) {
+		SetComponentTickEnabled(false);
+	}
+}
+
+void UInputBroadcaster::_UpdateTickEnabled() {
+	SetComponentTickEnabled(Queued && AutoDispatch);
+}
+
+void UInputBroadcaster::SetQueued(bool NewQueued) {
+	Queued = NewQueued;
+	// Nothing else will dispatch what is left.
+	if (!Queued && AutoDispatch) {
+		ProcessQueue();
+	}
+	_UpdateTickEnabled();
+}
+
+void UInputBroadcaster::SetAutoDispatch(bool NewAutoDispatch) {
+	AutoDispatch = NewAutoDispatch;
+	_UpdateTickEnabled();
+}
+
 void UInputBroadcaster::PrepareInputList(uint8 Max) {
 	InputList.SetNum(Max,true);
+	NativeInputList.SetNum(Max, true);
 }
 
 FInputBroadcastDelegate* UInputBroadcaster::GetInputDelegate(uint8 Input) {
@@ -16,4 +56,44 @@ FInputBroadcastDelegate* UInputBroadcaster::GetInputDelegate(uint8 Input) {
 		return &(InputList[Input]);
 	}
 	return nullptr;
-}
\ No newline at end of file
+}
+
+FNativeInputBroadcastDelegate* UInputBroadcaster::GetNativeInputDelegate(uint8 Input) {
+	if (Input < NativeInputList.Num()) {
+		return &(NativeInputList[Input]);
+	}
+	return nullptr;
+}
+
+void UInputBroadcaster::BroadcastInput(uint8 Input, EInputBroadcastState State, float Magnitude) {
+	if (Queued) {
+		Queue.Enqueue({ Input, State, Magnitude, FPlatformTime::Seconds(), GFrameCounter });
+		// Queued may have been set directly after BeginPlay.
+		if (AutoDispatch && IsInGameThread() && HasBegunPlay() && !IsComponentTickEnabled()) {
+			SetComponentTickEnabled(true);
+		}
+		return;
+	}
+	Dispatch(Input, State, Magnitude);
+}
+
+int32 UInputBroadcaster::ProcessQueue() {
+	bool Trace = FInputLatency::IsEnabled();
+	return DrainQueue([this, Trace](const FInputBroadcastEvent& Event) {
+		if (Trace) {
+			FInputLatency::AddSample(EInputLatencyStage::BroadcastDispatch, (float)((FPlatformTime::Seconds() - Event.QueuedSeconds) * 1000.0), (uint32)(GFrameCounter - Event.QueuedFrame));
+		}
+		Dispatch(Event.Input, Event.State, Event.Magnitude);
+	});
+}
+
+void UInputBroadcaster::Dispatch(uint8 Input, EInputBroadcastState State, float Magnitude) {
+	OnAnyInput.Broadcast(Input, State, Magnitude);
+	if (Input < NativeInputList.Num()) {
+		NativeInputList[Input].Broadcast(State, Magnitude);
+	}
+	// Skip ProcessEvent entirely when nothing is bound.
+	if (Input < InputList.Num() && InputList[Input].IsBound()) {
+		InputList[Input].Broadcast(State, Magnitude);
+	}
+}
@@ -0,0 +1,95 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InputBuffer.h"
+#include "Engine/World.h"
+
+UInputBuffer::UInputBuffer() {
+	PrimaryComponentTick.bCanEverTick = false;
+	Head = 0;
+	Count = 0;
+	Undrained = 0;
+	for (auto i = 0; i < MaxAxes; ++i) {
+		AxisValues[i] = 0.f;
+	}
+}
+
+void UInputBuffer::Push(uint8 Input, EBufferedInputType Type, float Value) {
+	// Full, overwrite the oldest.
+	if (Count == Capacity) {
+		Head = (Head + 1) % Capacity;
+		Count--;
+	}
+
+	auto& Event = At(Count);
+	Event.Time = GetWorld() ? GetWorld()->GetTimeSeconds() : 0.f;
+	Event.Input = Input;
+	Event.Type = Type;
+	Event.Value = Value;
+	Event.Consumed = false;
+
+	Count++;
+	Undrained = FMath::Min(Undrained + 1, Count);
+}
+
+void UInputBuffer::RecordAxis(uint8 Input, float Value) {
+	if (Input < MaxAxes) {
+		// Unchanged axis values carry no information, don't spend ring space on them.
+		if (AxisValues[Input] == Value) {
+			return;
+		}
+		AxisValues[Input] = Value;
+	}
+	Push(Input, EBufferedInputType::Axis, Value);
+}
+
+void UInputBuffer::RecordAction(uint8 Input, bool Pressed) {
+	Push(Input, Pressed ? EBufferedInputType::Pressed : EBufferedInputType::Released, Pressed ? 1.f : 0.f);
+}
+
+float UInputBuffer::GetAxis(uint8 Input) const {
+	if (Input < MaxAxes) {
+		return AxisValues[Input];
+	}
+	return 0.f;
+}
+
+bool UInputBuffer::ConsumeAction(uint8 Input, float Window) {
+	float Now = GetWorld() ? GetWorld()->GetTimeSeconds() : 0.f;
+
+	// Newest first, stop once outside of the window.
+	for (int32 i = Count - 1; i >= 0; --i) {
+		auto& Event = At(i);
+		if (Now - Event.Time > Window) {
+			return false;
+		}
+		if (Event.Input == Input && Event.Type == EBufferedInputType::Pressed && !Event.Consumed) {
+			Event.Consumed = true;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool UInputBuffer::HasBufferedAction(uint8 Input, float Window) {
+	float Now = GetWorld() ? GetWorld()->GetTimeSeconds() : 0.f;
+	for (int32 i = Count - 1; i >= 0; --i) {
+		auto& Event = At(i);
+		if (Now - Event.Time > Window) {
+			return false;
+		}
+		if (Event.Input == Input && Event.Type == EBufferedInputType::Pressed && !Event.Consumed) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void UInputBuffer::Clear() {
+	Head = 0;
+	Count = 0;
+	Undrained = 0;
+	for (auto i = 0; i < MaxAxes; ++i) {
+		AxisValues[i] = 0.f;
+	}
+}
@@ -0,0 +1,150 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InputLatency.h"
+#include "HAL/IConsoleManager.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+
+CSV_DEFINE_CATEGORY(PCPPInputLatency, true);
+
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Input -> Motion P50 (ms)"), STAT_PCPPInputLatencyP50, STATGROUP_PCPPInputLatency);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Input -> Motion P95 (ms)"), STAT_PCPPInputLatencyP95, STATGROUP_PCPPInputLatency);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Input -> Motion P99 (ms)"), STAT_PCPPInputLatencyP99, STATGROUP_PCPPInputLatency);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Input -> Motion Frames (Last)"), STAT_PCPPInputLatencyFrames, STATGROUP_PCPPInputLatency);
+
+static TAutoConsoleVariable<int32> CVarPCPPInputTraceLatency(
+	TEXT("pcpp.Input.TraceLatency"),
+	0,
+	TEXT("Follow inputs from UDDDDriver / UInputBroadcaster to the movement that applies them and record the latency."),
+	ECVF_Default);
+
+static FAutoConsoleCommand CmdPCPPInputLatencyReport(
+	TEXT("pcpp.Input.LatencyReport"),
+	TEXT("Logs input latency percentiles per stage."),
+	FConsoleCommandDelegate::CreateStatic(&FInputLatency::Report));
+
+static FAutoConsoleCommand CmdPCPPInputLatencyReset(
+	TEXT("pcpp.Input.LatencyReset"),
+	TEXT("Drops every input latency sample."),
+	FConsoleCommandDelegate::CreateStatic(&FInputLatency::Reset));
+
+static const TCHAR* InputLatencyStageNames[] = {
+	TEXT("InputVector"),
+	TEXT("ModeChange"),
+	TEXT("Launch"),
+	TEXT("MovementTick"),
+	TEXT("BroadcastDispatch")
+};
+
+FInputLatency::FStageSamples FInputLatency::Samples[(int32)EInputLatencyStage::MAX];
+
+bool FInputLatency::IsEnabled() {
+	return CVarPCPPInputTraceLatency.GetValueOnGameThread() != 0;
+}
+
+void FInputLatency::Begin(FInputLatencyTrace& Trace, uint8 Input) {
+	// Keep following the older input, it is the one still waiting the longest.
+	if (Trace.Active || !IsEnabled()) {
+		return;
+	}
+	Trace.StartSeconds = FPlatformTime::Seconds();
+	Trace.StartFrame = GFrameCounter;
+	Trace.Input = Input;
+	Trace.Reached = 0;
+	Trace.Active = true;
+}
+
+void FInputLatency::Mark(FInputLatencyTrace& Trace, EInputLatencyStage Stage) {
+	uint8 Bit = 1 << (uint8)Stage;
+	if (!Trace.Active || (Trace.Reached & Bit)) {
+		return;
+	}
+	Trace.Reached |= Bit;
+	AddSample(Stage, (float)((FPlatformTime::Seconds() - Trace.StartSeconds) * 1000.0), (uint32)(GFrameCounter - Trace.StartFrame));
+}
+
+void FInputLatency::End(FInputLatencyTrace& Trace) {
+	Mark(Trace, EInputLatencyStage::MovementTick);
+	Trace.Active = false;
+}
+
+void FInputLatency::Drop(FInputLatencyTrace& Trace) {
+	Trace.Active = false;
+}
+
+bool FInputLatency::IsApplied(const FInputLatencyTrace& Trace) {
+	const uint8 Applied = (1 << (uint8)EInputLatencyStage::InputVector) | (1 << (uint8)EInputLatencyStage::ModeChange) | (1 << (uint8)EInputLatencyStage::Launch);
+	return (Trace.Reached & Applied) != 0;
+}
+
+void FInputLatency::AddSample(EInputLatencyStage Stage, float Milliseconds, uint32 Frames) {
+	auto& Ring = Samples[(int32)Stage];
+	Ring.Milliseconds[Ring.Head] = Milliseconds;
+	Ring.Frames[Ring.Head] = Frames;
+	Ring.Head = (Ring.Head + 1) % MaxSamples;
+	Ring.Count = FMath::Min(Ring.Count + 1, MaxSamples);
+
+	switch (Stage) {
+		case EInputLatencyStage::InputVector:
+			CSV_CUSTOM_STAT(PCPPInputLatency, InputVectorMs, Milliseconds, ECsvCustomStatOp::Set);
+			break;
+		case EInputLatencyStage::ModeChange:
+			CSV_CUSTOM_STAT(PCPPInputLatency, ModeChangeMs, Milliseconds, ECsvCustomStatOp::Set);
+			break;
+		case EInputLatencyStage::Launch:
+			CSV_CUSTOM_STAT(PCPPInputLatency, LaunchMs, Milliseconds, ECsvCustomStatOp::Set);
+			break;
+		case EInputLatencyStage::MovementTick:
+			CSV_CUSTOM_STAT(PCPPInputLatency, MovementTickMs, Milliseconds, ECsvCustomStatOp::Set);
+			CSV_CUSTOM_STAT(PCPPInputLatency, MovementTickFrames, (int32)Frames, ECsvCustomStatOp::Set);
+			// End to end, the headline numbers.
+			SET_FLOAT_STAT(STAT_PCPPInputLatencyP50, GetPercentile(Stage, 50.f));
+			SET_FLOAT_STAT(STAT_PCPPInputLatencyP95, GetPercentile(Stage, 95.f));
+			SET_FLOAT_STAT(STAT_PCPPInputLatencyP99, GetPercentile(Stage, 99.f));
+			SET_DWORD_STAT(STAT_PCPPInputLatencyFrames, Frames);
+			break;
+		case EInputLatencyStage::BroadcastDispatch:
+			CSV_CUSTOM_STAT(PCPPInputLatency, BroadcastDispatchMs, Milliseconds, ECsvCustomStatOp::Set);
+			break;
+		default:
+			break;
+	}
+}
+
+float FInputLatency::ComputePercentile(const float* Values, int32 Count, float Percent) {
+	if (Count == 0) {
+		return 0.f;
+	}
+	float Sorted[MaxSamples];
+	FMemory::Memcpy(Sorted, Values, Count * sizeof(float));
+	Sort(Sorted, Count);
+	int32 Index = FMath::Clamp(FMath::CeilToInt(Percent / 100.f * Count) - 1, 0, Count - 1);
+	return Sorted[Index];
+}
+
+float FInputLatency::GetPercentile(EInputLatencyStage Stage, float Percent) {
+	const auto& Ring = Samples[(int32)Stage];
+	// Order doesn't matter, the ring is used as is.
+	return ComputePercentile(Ring.Milliseconds, Ring.Count, Percent);
+}
+
+void FInputLatency::Report() {
+	for (int32 i = 0; i < (int32)EInputLatencyStage::MAX; ++i) {
+		const auto& Ring = Samples[i];
+		float Frames[MaxSamples];
+		for (int32 s = 0; s < Ring.Count; ++s) {
+			Frames[s] = (float)Ring.Frames[s];
+		}
+		UE_LOG(LogTemp, Log, TEXT("InputLatency %-18s Samples %4d  P50 %7.3fms  P95 %7.3fms  P99 %7.3fms  Frames P50 %.0f P99 %.0f"),
+			InputLatencyStageNames[i], Ring.Count,
+			GetPercentile((EInputLatencyStage)i, 50.f), GetPercentile((EInputLatencyStage)i, 95.f), GetPercentile((EInputLatencyStage)i, 99.f),
+			ComputePercentile(Frames, Ring.Count, 50.f), ComputePercentile(Frames, Ring.Count, 99.f));
+	}
+}
+
+void FInputLatency::Reset() {
+	for (int32 i = 0; i < (int32)EInputLatencyStage::MAX; ++i) {
+		Samples[i].Head = 0;
+		Samples[i].Count = 0;
+	}
+}
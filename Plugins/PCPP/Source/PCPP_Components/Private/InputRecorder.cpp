@@ -0,0 +1,266 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InputRecorder.h"
+#include "DDDDriver.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PawnMovementComponent.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/MemoryReader.h"
+#include "PCPP_UE4.h"
+
+// File header. "PCIR" + version.
+static const uint32 InputRecordMagic = 0x52494350;
+static const uint16 InputRecordVersion = 1;
+
+// The source is stored in the top bit of the input byte.
+static const uint8 InputRecordBroadcasterBit = 0x80;
+
+UInputRecorder::UInputRecorder() {
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.TickGroup = ETickingGroup::TG_PrePhysics;
+	Mode = EInputRecorderMode::Disabled;
+	FileName = TEXT("InputRecording.pcppinput");
+	Active = false;
+	Started = false;
+	StartFrame = 0;
+	ReplayIndex = 0;
+	LastFrameSeconds = 0.0;
+	ExitAfterReplay = false;
+	Driver = nullptr;
+	Broadcaster = nullptr;
+}
+
+FString UInputRecorder::GetFullPath() const {
+	if (FPaths::IsRelative(FileName)) {
+		return FPaths::Combine(FPaths::ProjectSavedDir(), FileName);
+	}
+	return FileName;
+}
+
+void UInputRecorder::BeginPlay() {
+	Super::BeginPlay();
+
+	// Command line overrides.
+	FString CommandLineFile;
+	if (FParse::Value(FCommandLine::Get(), TEXT("PCPPRecordInput="), CommandLineFile)) {
+		Mode = EInputRecorderMode::Record;
+		FileName = CommandLineFile;
+	}
+	if (FParse::Value(FCommandLine::Get(), TEXT("PCPPReplayInput="), CommandLineFile)) {
+		Mode = EInputRecorderMode::Replay;
+		FileName = CommandLineFile;
+	}
+	ExitAfterReplay = FParse::Param(FCommandLine::Get(), TEXT("PCPPReplayExit"));
+
+	APawn* PawnOwner = Cast<APawn>(GetOwner());
+	if (Mode == EInputRecorderMode::Disabled || !PawnOwner) {
+		SetComponentTickEnabled(false);
+		return;
+	}
+
+	// Pawns are usually possessed after BeginPlay, start once locally controlled.
+	SetComponentTickEnabled(false);
+	PawnOwner->ReceiveControllerChangedDelegate.AddDynamic(this, &UInputRecorder::OnControllerChanged);
+	Start();
+}
+
+void UInputRecorder::OnControllerChanged(APawn* Pawn, AController* OldController, AController* NewController) {
+	Start();
+}
+
+void UInputRecorder::Start() {
+	// Only the locally controlled pawn has input to record / replay.
+	APawn* PawnOwner = Cast<APawn>(GetOwner());
+	if (Started || !PawnOwner || !PawnOwner->IsLocallyControlled()) {
+		return;
+	}
+	Started = true;
+
+	PCPP_UE4::LazyGetComp(GetOwner(), Driver);
+	PCPP_UE4::LazyGetComp(GetOwner(), Broadcaster);
+
+	if (Mode == EInputRecorderMode::Record) {
+		Records.Reset();
+		if (Broadcaster) {
+			BroadcasterHandle = Broadcaster->OnAnyInput.AddUObject(this, &UInputRecorder::OnBroadcasterInput);
+		}
+		// Records are pushed by the sources, nothing to do per frame.
+		Active = true;
+	}
+
+	if (Mode == EInputRecorderMode::Replay) {
+		if (!Load()) {
+			UE_LOG(LogTemp, Warning, TEXT("UInputRecorder: Unable to load %s"), *GetFullPath());
+			return;
+		}
+
+		// Identical gameplay requires identical timesteps.
+		float FPS = 60.f;
+		FParse::Value(FCommandLine::Get(), TEXT("PCPPReplayFPS="), FPS);
+		FApp::SetUseFixedTimeStep(true);
+		FApp::SetFixedDeltaTime(1.0 / FMath::Max(FPS, 1.f));
+
+		// Injected input must arrive before the driver / movement handles it.
+		if (Driver) {
+			Driver->PrimaryComponentTick.AddPrerequisite(this, PrimaryComponentTick);
+		}
+		if (auto Movement = PawnOwner->GetMovementComponent()) {
+			Movement->PrimaryComponentTick.AddPrerequisite(this, PrimaryComponentTick);
+		}
+
+		FrameTimes.Reset(Records.Num() > 0 ? Records.Last().Frame + 1 : 0);
+		LastFrameSeconds = FPlatformTime::Seconds();
+		Active = true;
+		SetComponentTickEnabled(true);
+	}
+	StartFrame = GFrameCounter;
+}
+
+void UInputRecorder::EndPlay(const EEndPlayReason::Type EndPlayReason) {
+	if (APawn* PawnOwner = Cast<APawn>(GetOwner())) {
+		PawnOwner->ReceiveControllerChangedDelegate.RemoveDynamic(this, &UInputRecorder::OnControllerChanged);
+	}
+	if (Broadcaster && BroadcasterHandle.IsValid()) {
+		Broadcaster->OnAnyInput.Remove(BroadcasterHandle);
+	}
+	if (IsRecording()) {
+		Save();
+	}
+	if (Mode == EInputRecorderMode::Replay && Active) {
+		WriteFrameTimes();
+	}
+	Active = false;
+	Super::EndPlay(EndPlayReason);
+}
+
+void UInputRecorder::RecordDriverInput(uint8 Input, float Value) {
+	if (IsRecording()) {
+		Records.Add({ GetFrame(), EInputRecordSource::Driver, Input, 0, Value });
+	}
+}
+
+void UInputRecorder::OnBroadcasterInput(uint8 Input, EInputBroadcastState State, float Magnitude) {
+	if (IsRecording()) {
+		Records.Add({ GetFrame(), EInputRecordSource::Broadcaster, Input, (uint8)State, Magnitude });
+	}
+}
+
+void UInputRecorder::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) {
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (!Active) {
+		return;
+	}
+
+	if (Mode == EInputRecorderMode::Replay) {
+		uint32 Frame = GetFrame();
+
+		// Frame time of the previous frame.
+		double Now = FPlatformTime::Seconds();
+		if (Frame > 0) {
+			FrameTimes.Add({ Frame - 1, (float)((Now - LastFrameSeconds) * 1000.0), FPlatformTime::ToMilliseconds(GGameThreadTime) });
+		}
+		LastFrameSeconds = Now;
+
+		// Feed every record for this frame.
+		while (ReplayIndex < Records.Num() && Records[ReplayIndex].Frame <= Frame) {
+			const auto& Record = Records[ReplayIndex];
+			if (Record.Source == EInputRecordSource::Driver) {
+				if (Driver) {
+					Driver->InjectInput(Record.Input, Record.Value);
+				}
+			} else if (Broadcaster) {
+				Broadcaster->BroadcastInput(Record.Input, (EInputBroadcastState)Record.State, Record.Value);
+			}
+			ReplayIndex++;
+		}
+
+		// Done.
+		if (ReplayIndex >= Records.Num()) {
+			WriteFrameTimes();
+			Active = false;
+			if (ExitAfterReplay) {
+				FPlatformMisc::RequestExit(false);
+			}
+		}
+	}
+}
+
+void UInputRecorder::Save() {
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+
+	uint32 Magic = InputRecordMagic;
+	uint16 Version = InputRecordVersion;
+	int32 Count = Records.Num();
+	Writer << Magic << Version << Count;
+
+	// Frames are stored as packed deltas, most records are on the same or the next frame.
+	uint32 PreviousFrame = 0;
+	for (auto It = Records.CreateIterator(); It; ++It) {
+		uint32 Delta = It->Frame - PreviousFrame;
+		PreviousFrame = It->Frame;
+		Writer.SerializeIntPacked(Delta);
+
+		uint8 InputByte = (It->Input & ~InputRecordBroadcasterBit) | (It->Source == EInputRecordSource::Broadcaster ? InputRecordBroadcasterBit : 0);
+		Writer << InputByte;
+		if (It->Source == EInputRecordSource::Broadcaster) {
+			Writer << It->State;
+		}
+		Writer << It->Value;
+	}
+
+	FFileHelper::SaveArrayToFile(Bytes, *GetFullPath());
+}
+
+bool UInputRecorder::Load() {
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *GetFullPath())) {
+		return false;
+	}
+	FMemoryReader Reader(Bytes);
+
+	uint32 Magic = 0;
+	uint16 Version = 0;
+	int32 Count = 0;
+	Reader << Magic << Version << Count;
+	if (Magic != InputRecordMagic || Version != InputRecordVersion || Count < 0) {
+		return false;
+	}
+
+	Records.Reset(Count);
+	uint32 PreviousFrame = 0;
+	for (int32 i = 0; i < Count && !Reader.IsError(); ++i) {
+		FInputRecord Record;
+		uint32 Delta = 0;
+		Reader.SerializeIntPacked(Delta);
+		Record.Frame = PreviousFrame + Delta;
+		PreviousFrame = Record.Frame;
+
+		uint8 InputByte = 0;
+		Reader << InputByte;
+		Record.Source = (InputByte & InputRecordBroadcasterBit) ? EInputRecordSource::Broadcaster : EInputRecordSource::Driver;
+		Record.Input = InputByte & ~InputRecordBroadcasterBit;
+		Record.State = 0;
+		if (Record.Source == EInputRecordSource::Broadcaster) {
+			Reader << Record.State;
+		}
+		Reader << Record.Value;
+		Records.Add(Record);
+	}
+	ReplayIndex = 0;
+	return !Reader.IsError();
+}
+
+void UInputRecorder::WriteFrameTimes() {
+	FString Csv = TEXT("Frame,FrameMs,GameThreadMs\n");
+	for (auto It = FrameTimes.CreateConstIterator(); It; ++It) {
+		Csv += FString::Printf(TEXT("%u,%.3f,%.3f\n"), It->Frame, It->WallMs, It->GameThreadMs);
+	}
+	FFileHelper::SaveStringToFile(Csv, *(GetFullPath() + TEXT(".csv")));
+}
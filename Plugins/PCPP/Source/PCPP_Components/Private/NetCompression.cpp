@@ -0,0 +1,228 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NetCompression.h"
+#include "NetReplicate.h"
+#include "NetReplicateTelemetry.h"
+#include "NetDelta.h"
+#include "Misc/Compression.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/MemoryReader.h"
+#include "HAL/IConsoleManager.h"
+#include "Compression/lz4.h"
+
+THIRD_PARTY_INCLUDES_START
+#include "zlib.h"
+THIRD_PARTY_INCLUDES_END
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Compressed Payloads"), STAT_PCPPNetCompressions, STATGROUP_PCPPNetReplicate);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Compress (ms)"), STAT_PCPPNetCompressMs, STATGROUP_PCPPNetReplicate);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Decompress (ms)"), STAT_PCPPNetDecompressMs, STATGROUP_PCPPNetReplicate);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Compression Ratio"), STAT_PCPPNetCompressionRatio, STATGROUP_PCPPNetReplicate);
+
+static TAutoConsoleVariable<int32> CVarPCPPNetCompressionThreshold(
+	TEXT("pcpp.Net.CompressionThreshold"),
+	256,
+	TEXT("Full UNetReplicate payloads of at least this many bytes are compressed. 0 disables compression."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarPCPPNetCompressionCodec(
+	TEXT("pcpp.Net.CompressionCodec"),
+	0,
+	TEXT("Codec of compressed UNetReplicate payloads without a dictionary. 0: Zlib, 1: LZ4"),
+	ECVF_Default);
+
+static FAutoConsoleCommand CmdPCPPNetCompressionReport(
+	TEXT("pcpp.Net.CompressionReport"),
+	TEXT("Logs the compression ratio and CPU time of UNetReplicate payloads."),
+	FConsoleCommandDelegate::CreateStatic(&FNetCompression::Report));
+
+static FName GetNetCompressionFormat(uint8 Codec) {
+	return Codec == FNetCompression::LZ4 ? NAME_LZ4 : NAME_Zlib;
+}
+
+TMap<uint8, TArray<uint8>> FNetCompression::Dictionaries;
+int64 FNetCompression::RawBytes = 0;
+int64 FNetCompression::CompressedBytes = 0;
+int64 FNetCompression::Compressions = 0;
+int64 FNetCompression::Skipped = 0;
+uint64 FNetCompression::CompressCycles = 0;
+int64 FNetCompression::Decompressions = 0;
+uint64 FNetCompression::DecompressCycles = 0;
+
+int32 FNetCompression::GetHeaderSize(const TArray<uint8>& Payload) {
+	return (Payload[0] & ENetPayloadFlags::Predicted) ? 4 : 1;
+}
+
+bool FNetCompression::IsCompressed(const TArray<uint8>& Payload) {
+	return Payload.Num() > 0 && (Payload[0] & ENetPayloadFlags::Compressed);
+}
+
+bool FNetCompression::Compress(TArray<uint8>& Payload, uint8 Dictionary) {
+	int32 Threshold = CVarPCPPNetCompressionThreshold.GetValueOnGameThread();
+	if (Threshold <= 0 || Payload.Num() < Threshold || IsCompressed(Payload)) {
+		return false;
+	}
+	uint64 Start = FPlatformTime::Cycles64();
+
+	int32 HeaderSize = GetHeaderSize(Payload);
+	const uint8* Body = Payload.GetData() + HeaderSize;
+	int32 BodyLength = Payload.Num() - HeaderSize;
+
+	auto Found = Dictionary != 0 ? Dictionaries.Find(Dictionary) : nullptr;
+	uint8 Codec = Found ? ZlibDictionary : (uint8)FMath::Clamp(CVarPCPPNetCompressionCodec.GetValueOnGameThread(), 0, (int32)ZlibDictionary - 1);
+	uint8 DictionaryId = Found ? Dictionary : 0;
+
+	TArray<uint8> Compressed;
+	bool Success = false;
+	if (Codec == ZlibDictionary) {
+		Success = ZlibDictionaryCompress(*Found, Body, BodyLength, Compressed);
+	} else {
+		int32 CompressedLength = FCompression::CompressMemoryBound(GetNetCompressionFormat(Codec), BodyLength);
+		Compressed.SetNumUninitialized(CompressedLength);
+		Success = FCompression::CompressMemory(GetNetCompressionFormat(Codec), Compressed.GetData(), CompressedLength, Body, BodyLength);
+		Compressed.SetNum(Success ? CompressedLength : 0, false);
+	}
+
+	// Header, Codec, Dictionary, Length (up to 5 bytes), Body.
+	TArray<uint8> Out;
+	if (Success && HeaderSize + 2 + 5 + Compressed.Num() < Payload.Num()) {
+		Out.Reserve(HeaderSize + 7 + Compressed.Num());
+		FMemoryWriter Writer(Out);
+		Writer.Serialize(Payload.GetData(), HeaderSize);
+		uint32 Length = BodyLength;
+		Writer << Codec << DictionaryId;
+		Writer.SerializeIntPacked(Length);
+		Writer.Serialize(Compressed.GetData(), Compressed.Num());
+		Out[0] |= ENetPayloadFlags::Compressed;
+	}
+
+	uint64 Cycles = FPlatformTime::Cycles64() - Start;
+	CompressCycles += Cycles;
+	INC_FLOAT_STAT_BY(STAT_PCPPNetCompressMs, (float)FPlatformTime::ToMilliseconds64(Cycles));
+	if (Out.Num() == 0) {
+		Skipped++;
+		return false;
+	}
+
+	Compressions++;
+	RawBytes += Payload.Num();
+	CompressedBytes += Out.Num();
+	INC_DWORD_STAT(STAT_PCPPNetCompressions);
+	SET_FLOAT_STAT(STAT_PCPPNetCompressionRatio, (float)CompressedBytes / RawBytes);
+	Payload = MoveTemp(Out);
+	return true;
+}
+
+bool FNetCompression::Decompress(TArray<uint8>& Payload) {
+	if (!IsCompressed(Payload)) {
+		return true;
+	}
+	uint64 Start = FPlatformTime::Cycles64();
+
+	int32 HeaderSize = GetHeaderSize(Payload);
+	if (Payload.Num() < HeaderSize) {
+		return false;
+	}
+	FMemoryReader Reader(Payload);
+	Reader.Seek(HeaderSize);
+	uint8 Codec = 0;
+	uint8 DictionaryId = 0;
+	uint32 Length = 0;
+	Reader << Codec << DictionaryId;
+	Reader.SerializeIntPacked(Length);
+	if (Reader.IsError() || Codec >= MAX || Length > FNetDelta::MaxPayloadSize) {
+		return false;
+	}
+	const uint8* Compressed = Payload.GetData() + Reader.Tell();
+	int32 CompressedLength = Payload.Num() - (int32)Reader.Tell();
+
+	TArray<uint8> Out;
+	Out.SetNumUninitialized(HeaderSize + Length);
+	FMemory::Memcpy(Out.GetData(), Payload.GetData(), HeaderSize);
+	Out[0] &= ~ENetPayloadFlags::Compressed;
+
+	// FCompression::UncompressMemory is fatal on corrupt data, payloads come from remote machines.
+	bool Success = false;
+	if (Codec == ZlibDictionary) {
+		auto Found = Dictionaries.Find(DictionaryId);
+		Success = Found && ZlibUncompress(Found, Compressed, CompressedLength, Out.GetData() + HeaderSize, Length);
+	} else if (Codec == LZ4) {
+		Success = LZ4Uncompress(Compressed, CompressedLength, Out.GetData() + HeaderSize, Length);
+	} else {
+		Success = ZlibUncompress(nullptr, Compressed, CompressedLength, Out.GetData() + HeaderSize, Length);
+	}
+
+	uint64 Cycles = FPlatformTime::Cycles64() - Start;
+	Decompressions++;
+	DecompressCycles += Cycles;
+	INC_FLOAT_STAT_BY(STAT_PCPPNetDecompressMs, (float)FPlatformTime::ToMilliseconds64(Cycles));
+	if (Success) {
+		Payload = MoveTemp(Out);
+	}
+	return Success;
+}
+
+bool FNetCompression::ZlibDictionaryCompress(const TArray<uint8>& Dictionary, const uint8* Data, int32 Length, TArray<uint8>& Out) {
+	z_stream Stream;
+	FMemory::Memzero(Stream);
+	if (deflateInit(&Stream, Z_DEFAULT_COMPRESSION) != Z_OK) {
+		return false;
+	}
+	bool Success = false;
+	if (deflateSetDictionary(&Stream, Dictionary.GetData(), Dictionary.Num()) == Z_OK) {
+		Out.SetNumUninitialized(deflateBound(&Stream, Length));
+		Stream.next_in = const_cast<uint8*>(Data);
+		Stream.avail_in = Length;
+		Stream.next_out = Out.GetData();
+		Stream.avail_out = Out.Num();
+		Success = deflate(&Stream, Z_FINISH) == Z_STREAM_END;
+		Out.SetNum(Success ? (int32)Stream.total_out : 0, false);
+	}
+	deflateEnd(&Stream);
+	return Success;
+}
+
+bool FNetCompression::ZlibUncompress(const TArray<uint8>* Dictionary, const uint8* Data, int32 Length, uint8* Out, int32 OutLength) {
+	z_stream Stream;
+	FMemory::Memzero(Stream);
+	if (inflateInit(&Stream) != Z_OK) {
+		return false;
+	}
+	Stream.next_in = const_cast<uint8*>(Data);
+	Stream.avail_in = Length;
+	Stream.next_out = Out;
+	Stream.avail_out = OutLength;
+	int Result = inflate(&Stream, Z_FINISH);
+	// The dictionary is asked for once the header is read.
+	if (Result == Z_NEED_DICT && Dictionary && inflateSetDictionary(&Stream, Dictionary->GetData(), Dictionary->Num()) == Z_OK) {
+		Result = inflate(&Stream, Z_FINISH);
+	}
+	bool Success = Result == Z_STREAM_END && (int32)Stream.total_out == OutLength;
+	inflateEnd(&Stream);
+	return Success;
+}
+
+bool FNetCompression::LZ4Uncompress(const uint8* Data, int32 Length, uint8* Out, int32 OutLength) {
+	return LZ4_decompress_safe((const char*)Data, (char*)Out, Length, OutLength) == OutLength;
+}
+
+void FNetCompression::RegisterDictionary(uint8 Id, const TArray<uint8>& Dictionary) {
+	if (Id == 0 || Dictionary.Num() == 0) {
+		return;
+	}
+	Dictionaries.Add(Id, Dictionary);
+}
+
+void FNetCompression::RegisterDictionary(uint8 Id, const FString& Sample) {
+	FTCHARToUTF8 Utf8(*Sample);
+	RegisterDictionary(Id, TArray<uint8>((const uint8*)Utf8.Get(), Utf8.Length()));
+}
+
+void FNetCompression::Report() {
+	UE_LOG(LogTemp, Log, TEXT("NetCompression Compressed %lld (Skipped %lld)  %lld -> %lld bytes  Ratio %.3f  Compress %.2fus avg  Decompressed %lld  Decompress %.2fus avg  Dictionaries %d"),
+		Compressions, Skipped, RawBytes, CompressedBytes, RawBytes > 0 ? (double)CompressedBytes / RawBytes : 1.0,
+		(Compressions + Skipped) > 0 ? FPlatformTime::ToMilliseconds64(CompressCycles) * 1000.0 / (Compressions + Skipped) : 0.0,
+		Decompressions, Decompressions > 0 ? FPlatformTime::ToMilliseconds64(DecompressCycles) * 1000.0 / Decompressions : 0.0,
+		Dictionaries.Num());
+}
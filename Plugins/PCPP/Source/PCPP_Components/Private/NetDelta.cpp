@@ -0,0 +1,200 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NetDelta.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/MemoryReader.h"
+
+FNetDeltaSender::FNetDeltaSender() {
+	Reset();
+}
+
+void FNetDeltaSender::Reset() {
+	History.Reset();
+	Acked.Id = 0;
+	Acked.Payload.Reset();
+	HasAcked = false;
+	Delivered = false;
+	NextId = 0;
+	SendsSinceKeyframe = 0;
+	SkipsSinceSend = 0;
+}
+
+void FNetDeltaSender::ForceKeyframe() {
+	History.Reset();
+	HasAcked = false;
+	Delivered = false;
+	SkipsSinceSend = 0;
+}
+
+void FNetDeltaSender::Deliver(const TArray<uint8>& Payload) {
+	History.Reset();
+	Acked.Payload = Payload;
+	HasAcked = false;
+	Delivered = true;
+	SkipsSinceSend = 0;
+}
+
+bool FNetDeltaSender::Encode(const TArray<uint8>& Payload, int32 KeyframeInterval, TArray<uint8>& Out) {
+	if (IsAcknowledged(Payload)) {
+		return false;
+	}
+	// Already on the way, give the ack a chance to arrive.
+	if (History.Num() > 0 && History.Last().Payload == Payload && ++SkipsSinceSend < ResendInterval) {
+		return false;
+	}
+	SkipsSinceSend = 0;
+
+	uint16 Id = NextId++;
+	bool Keyframe = !HasAcked || SendsSinceKeyframe >= KeyframeInterval;
+
+	if (!Keyframe) {
+		Out.Reset();
+		FMemoryWriter Writer(Out);
+		uint8 Flags = 0;
+		uint16 BaselineId = Acked.Id;
+		Writer << Flags << Id << BaselineId;
+		FNetDelta::WriteSpans(Acked.Payload, Payload, Writer);
+		// Not worth it, ie: everything changed.
+		Keyframe = (Out.Num() >= Payload.Num() + 3);
+	}
+
+	if (Keyframe) {
+		Out.Reset();
+		FMemoryWriter Writer(Out);
+		uint8 Flags = FNetDelta::Keyframe;
+		Writer << Flags << Id;
+		Writer.Serialize(const_cast<uint8*>(Payload.GetData()), Payload.Num());
+		SendsSinceKeyframe = 0;
+	} else {
+		SendsSinceKeyframe++;
+	}
+
+	if (History.Num() == MaxHistory) {
+		History.RemoveAt(0, 1, false);
+	}
+	History.Add({ Id, Payload });
+	return true;
+}
+
+bool FNetDeltaSender::IsAcknowledged(const TArray<uint8>& Payload) const {
+	return (HasAcked || Delivered) && History.Num() == 0 && Acked.Payload == Payload;
+}
+
+int32 FNetDeltaSender::Ack(uint16 Id) {
+	for (int32 i = 0; i < History.Num(); ++i) {
+		if (History[i].Id == Id) {
+			Acked = MoveTemp(History[i]);
+			HasAcked = true;
+			Delivered = false;
+			// Anything older is no longer a useful baseline.
+			History.RemoveAt(0, i + 1, false);
+			return i;
+		}
+	}
+	return 0;
+}
+
+FNetDeltaReceiver::FNetDeltaReceiver() {
+	LatestId = 0;
+	HasLatest = false;
+}
+
+bool FNetDeltaReceiver::Decode(const TArray<uint8>& Packet, TArray<uint8>& OutPayload, uint16& OutId) {
+	FMemoryReader Reader(Packet);
+	uint8 Flags = 0;
+	uint16 Id = 0;
+	Reader << Flags << Id;
+	if (Reader.IsError() || (HasLatest && !FNetDelta::IsNewer(Id, LatestId))) {
+		return false;
+	}
+
+	if (Flags & FNetDelta::Keyframe) {
+		int32 Offset = (int32)Reader.Tell();
+		OutPayload.SetNumUninitialized(Packet.Num() - Offset);
+		FMemory::Memcpy(OutPayload.GetData(), Packet.GetData() + Offset, OutPayload.Num());
+	} else {
+		uint16 BaselineId = 0;
+		Reader << BaselineId;
+		const FNetDeltaBaseline* Baseline = Baselines.FindByPredicate([BaselineId](const FNetDeltaBaseline& Entry) {
+			return Entry.Id == BaselineId;
+		});
+		// Wait for the next keyframe.
+		if (!Baseline || !FNetDelta::ReadSpans(Baseline->Payload, Reader, OutPayload)) {
+			return false;
+		}
+	}
+
+	if (Baselines.Num() == FNetDeltaSender::MaxHistory) {
+		Baselines.RemoveAt(0, 1, false);
+	}
+	Baselines.Add({ Id, OutPayload });
+	LatestId = Id;
+	HasLatest = true;
+	OutId = Id;
+	return true;
+}
+
+void FNetDelta::WriteSpans(const TArray<uint8>& Base, const TArray<uint8>& New, FArchive& Ar) {
+	// Changed ranges as (Start, Length).
+	TArray<TPair<int32, int32>, TInlineAllocator<16>> Spans;
+	int32 i = 0;
+	while (i < New.Num()) {
+		if (i < Base.Num() && Base[i] == New[i]) {
+			++i;
+			continue;
+		}
+		int32 Start = i;
+		int32 LastChange = i;
+		for (++i; i < New.Num() && i - LastChange <= MergeGap; ++i) {
+			if (i >= Base.Num() || Base[i] != New[i]) {
+				LastChange = i;
+			}
+		}
+		Spans.Add(TPair<int32, int32>(Start, LastChange + 1 - Start));
+		i = LastChange + 1;
+	}
+
+	uint32 Length = New.Num();
+	uint32 Count = Spans.Num();
+	Ar.SerializeIntPacked(Length);
+	Ar.SerializeIntPacked(Count);
+	int32 Cursor = 0;
+	for (auto It = Spans.CreateConstIterator(); It; ++It) {
+		uint32 Skip = It->Key - Cursor;
+		uint32 SpanLength = It->Value;
+		Ar.SerializeIntPacked(Skip);
+		Ar.SerializeIntPacked(SpanLength);
+		Ar.Serialize(const_cast<uint8*>(New.GetData()) + It->Key, SpanLength);
+		Cursor = It->Key + SpanLength;
+	}
+}
+
+bool FNetDelta::ReadSpans(const TArray<uint8>& Base, FArchive& Ar, TArray<uint8>& Out) {
+	uint32 Length = 0;
+	uint32 Count = 0;
+	Ar.SerializeIntPacked(Length);
+	Ar.SerializeIntPacked(Count);
+	if (Ar.IsError() || Length > MaxPayloadSize) {
+		return false;
+	}
+
+	// Start from the baseline, resized to the new length.
+	Out.SetNumZeroed(Length);
+	FMemory::Memcpy(Out.GetData(), Base.GetData(), FMath::Min((uint32)Base.Num(), Length));
+
+	uint32 Cursor = 0;
+	for (uint32 s = 0; s < Count; ++s) {
+		uint32 Skip = 0;
+		uint32 SpanLength = 0;
+		Ar.SerializeIntPacked(Skip);
+		Ar.SerializeIntPacked(SpanLength);
+		if (Ar.IsError() || (uint64)Cursor + Skip + SpanLength > Length) {
+			return false;
+		}
+		Cursor += Skip;
+		Ar.Serialize(Out.GetData() + Cursor, SpanLength);
+		Cursor += SpanLength;
+	}
+	return !Ar.IsError();
+}
@@ -3,12 +3,84 @@
 
 #include "NetReplicate.h"
 #include "Serialization/JsonSerializer.h"
+#include "Serialization/BitWriter.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/MemoryReader.h"
+#include "NetReplicateScheduler.h"
+#include "NetReplicateTelemetry.h"
+#include "NetCompression.h"
+#include "HAL/IConsoleManager.h"
+#include "UObject/UObjectIterator.h"
+#include "Misc/Crc.h"
+#include "GameFramework/PlayerController.h"
 #include "PCPP_UE4.h"
 
+static FAutoConsoleCommand CmdPCPPNetReplicationRates(
+	TEXT("pcpp.Net.ReplicationRates"),
+	TEXT("Logs the adaptive send interval and change rate of every replicated component."),
+	FConsoleCommandDelegate::CreateStatic(&UNetReplicate::ReportRates));
+
+int64 UNetReplicate::RPCCounts[ENetReplicateRPC::MAX] = {};
+int64 UNetReplicate::RPCBytes[ENetReplicateRPC::MAX] = {};
+
 UNetReplicate::UNetReplicate()
 {
-	PrimaryComponentTick.bCanEverTick = false;
+	PrimaryComponentTick.bCanEverTick = true;
 	PawnOwner = nullptr;
+	KeyframeInterval = 30;
+	AdaptiveReplication = true;
+	MaxReplicationInterval = 2.f;
+	ReplicationBackoff = 1.5f;
+	MaxPredictionHistory = 64;
+}
+
+void UNetReplicate::BeginPlay() {
+	Super::BeginPlay();
+	// One bundle per net update.
+	SetComponentTickInterval(1.f / FMath::Max(GetOwner()->NetUpdateFrequency, 1.f));
+	auto Scheduler = GetWorld()->GetSubsystem<UNetReplicateScheduler>();
+	if (Scheduler && GetOwner()->HasAuthority()) {
+		Scheduler->Register(this);
+	}
+}
+
+void UNetReplicate::EndPlay(const EEndPlayReason::Type EndPlayReason) {
+	auto Scheduler = GetWorld()->GetSubsystem<UNetReplicateScheduler>();
+	if (Scheduler) {
+		Scheduler->Unregister(this);
+	}
+	Super::EndPlay(EndPlayReason);
+}
+
+void UNetReplicate::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) {
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	PCPP_UE4::Network::Local(GetPawnOwner(), [&]() {
+		_OwnerSend();
+	});
+	_FlushMessages();
+}
+
+void UNetReplicate::_AssignNetIds() {
+	TArray<UActorComponent*> Components = GetOwner()->GetComponentsByInterface(UNetReplicatable::StaticClass());
+	// Names of default subobjects match on every machine, FName ordering does not.
+	Components.Sort([](const UActorComponent& A, const UActorComponent& B) {
+		return A.GetFName().LexicalLess(B.GetFName());
+	});
+
+	// IDs never move once assigned, the peers would keep the old numbering. Components added later are appended.
+	int32 Appended = 0;
+	for (auto Component : Components) {
+		auto Interface = Cast<INetReplicatable>(Component);
+		if (Entries.IsValidIndex(Interface->_NetId)) {
+			continue;
+		}
+		Interface->_NetId = Entries.AddDefaulted();
+		Appended++;
+	}
+	if (Appended > 0 && Entries.Num() > Appended) {
+		UE_LOG(LogTemp, Warning, TEXT("NetReplicate %s appended %d late component(s), they only match peers that add them in the same order."), *GetOwner()->GetName(), Appended);
+	}
 }
 
 void UNetReplicate::_ProcessReliableRequestFromInterface(UActorComponent * Target, bool Reliable)
@@ -16,106 +88,708 @@ void UNetReplicate::_ProcessReliableRequestFromInterface(UActorComponent * Targe
 	PCPP_UE4::Network::Local(GetPawnOwner(), [&]() {
 		auto Interface = Cast<INetReplicatable>(Target);
 		if (Interface) {
-			auto ReplicationData = PCPP_UE4::JSON::ToString(Interface->CreateReplicationData());
-			RequestReplication(Interface->_GetTag(), ReplicationData, true);
+			TArray<uint8> Payload;
+			CreatePayload(Interface, Payload);
+			RequestReplication(Interface->GetNetId(), Payload, Reliable);
 		}
 	});
 }
 
-bool UNetReplicate::Validate(const FString& ObjectID, const FString& ReplicateData) {
+bool UNetReplicate::Validate(int32 NetId, const TArray<uint8>& Payload) {
 	return true;
 }
 
-INetReplicatable* UNetReplicate::GetCachedComponentByTag(const FString& ObjectID) {
-	return PCPP_UE4::GetCachedComponentByTag<UActorComponent, INetReplicatable>(
-		GetOwner(), 
-		ObjectID, 
-		CachedComponents
-	);
+void UNetReplicate::CreatePayload(INetReplicatable* Component, TArray<uint8>& Out) {
+	int32 Slot = FNetReplicateTelemetry::GetSlot(Component);
+	uint64 Start = Slot != INDEX_NONE ? FPlatformTime::Cycles64() : 0;
+	if (Component->UsesBinaryReplication()) {
+		FBitWriter Writer(0, true);
+		uint8 Flags = ENetPayloadFlags::Binary;
+		Writer << Flags;
+		Component->SerializeReplication(Writer);
+		Out = *Writer.GetBuffer();
+		Out.SetNum(Writer.GetNumBytes());
+	} else {
+		_MakeJsonPayload(PCPP_UE4::JSON::ToString(Component->CreateReplicationData()), Out);
+	}
+	if (Slot != INDEX_NONE) {
+		FNetReplicateTelemetry::RecordSerialize(Slot, FPlatformTime::Cycles64() - Start, Out.Num());
+	}
+}
+
+void UNetReplicate::_MakeJsonPayload(const FString& Data, TArray<uint8>& Out) {
+	FTCHARToUTF8 Json(*Data);
+	Out.SetNumUninitialized(1 + Json.Length());
+	Out[0] = ENetPayloadFlags::None;
+	FMemory::Memcpy(Out.GetData() + 1, Json.Get(), Json.Length());
 }
 
-void UNetReplicate::ProcessReplicationRequest(const FString& ObjectID, const FString& ReplicateData) {
-	if (GetPawnOwner() && !GetPawnOwner()->IsLocallyControlled()) {
+bool UNetReplicate::ApplyPayload(INetReplicatable* Component, const TArray<uint8>& Payload) {
+	if (Payload.Num() == 0) {
+		return false;
+	}
+	if (FNetCompression::IsCompressed(Payload)) {
+		TArray<uint8> Uncompressed = Payload;
+		return FNetCompression::Decompress(Uncompressed) && ApplyPayload(Component, Uncompressed);
+	}
+	int32 Slot = FNetReplicateTelemetry::GetSlot(Component);
+	uint64 Start = Slot != INDEX_NONE ? FPlatformTime::Cycles64() : 0;
+	bool Applied = false;
+
+	// Skip the flag byte and prediction header.
+	int32 Offset = (Payload[0] & ENetPayloadFlags::Predicted) ? 4 : 1;
+	if (Payload.Num() < Offset) {
+		return false;
+	}
+
+	if (Payload[0] & ENetPayloadFlags::Binary) {
+		FBitReader Reader(const_cast<uint8*>(Payload.GetData()) + Offset, (Payload.Num() - Offset) * 8);
+		Component->SerializeReplication(Reader);
+		Applied = !Reader.IsError();
+	} else {
+		FUTF8ToTCHAR Json((const ANSICHAR*)Payload.GetData() + Offset, Payload.Num() - Offset);
 		FJsonObject Data;
-		if (PCPP_UE4::JSON::ToObject(ReplicateData, Data)) {
-			auto comp = GetCachedComponentByTag(ObjectID);
-			if (comp) {
-				comp->ReceiveReplicate(Data);
-			}
+		if (PCPP_UE4::JSON::ToObject(FString(Json.Length(), Json.Get()), Data)) {
+			Component->ReceiveReplicate(Data);
+			Applied = true;
+		}
+	}
+
+	if (Slot != INDEX_NONE) {
+		FNetReplicateTelemetry::RecordApply(Slot, FPlatformTime::Cycles64() - Start);
+	}
+	return Applied;
+}
+
+int32 UNetReplicate::_WriteBundleEntry(FArchive& Ar, int32 Index, const TArray<uint8>& Data) {
+	int64 Start = Ar.Tell();
+	uint32 PackedIndex = Index;
+	uint32 Length = Data.Num();
+	Ar.SerializeIntPacked(PackedIndex);
+	Ar.SerializeIntPacked(Length);
+	Ar.Serialize(const_cast<uint8*>(Data.GetData()), Length);
+	return (int32)(Ar.Tell() - Start);
+}
+
+template<typename Callback>
+void UNetReplicate::_ReadBundle(const TArray<uint8>& Bundle, Callback Foo) {
+	FMemoryReader Reader(Bundle);
+	TArray<uint8> Data;
+	while (Reader.Tell() < Reader.TotalSize()) {
+		uint32 Index = 0;
+		uint32 Length = 0;
+		Reader.SerializeIntPacked(Index);
+		Reader.SerializeIntPacked(Length);
+		if (Reader.IsError() || Index >= (uint32)Entries.Num() || Length > (uint32)(Reader.TotalSize() - Reader.Tell())) {
+			return;
 		}
+		Data.SetNumUninitialized(Length);
+		Reader.Serialize(Data.GetData(), Length);
+		Foo((int32)Index, Data);
 	}
 }
 
-void UNetReplicate::BroadcastMulticastUnreliable_Implementation(const FString& ObjectID, const FString& ReplicateData) {
-	ProcessReplicationRequest(ObjectID, ReplicateData);
+void UNetReplicate::_WriteAck(FArchive& Ar, int32 Index, uint16 Id) {
+	uint32 PackedIndex = Index;
+	Ar.SerializeIntPacked(PackedIndex);
+	Ar << Id;
+}
+
+void UNetReplicate::ProcessReplicationRequest(int32 Index, const TArray<uint8>& Payload) {
+	// Not registered on this machine.
+	if (GetPawnOwner() && !GetPawnOwner()->IsLocallyControlled() && Entries[Index].Component) {
+		ApplyPayload(Entries[Index].Component, Payload);
+	}
+}
+
+void UNetReplicate::ReceiveReliable(const TArray<uint8>& Bundle) {
+	TArray<uint8> Uncompressed;
+	_ReadBundle(Bundle, [&](int32 Index, const TArray<uint8>& Payload) {
+		Uncompressed = Payload;
+		if (FNetCompression::Decompress(Uncompressed)) {
+			ProcessReplicationRequest(Index, Uncompressed);
+		}
+	});
+}
+
+void UNetReplicate::BroadcastServerUnreliable_Implementation(const TArray<uint8>& Bundle) {
+	TArray<uint8> Acks;
+	FMemoryWriter AckWriter(Acks);
+	TArray<uint8> PredictionAcks;
+	FMemoryWriter PredictionAckWriter(PredictionAcks);
+	TArray<uint8> Payload;
+	_ReadBundle(Bundle, [&](int32 Index, const TArray<uint8>& Delta) {
+		auto& Entry = Entries[Index];
+		uint16 Id = 0;
+		if (Entry.State.FromOwner.Decode(Delta, Payload, Id)) {
+			_WriteAck(AckWriter, Index, Id);
+			// Only the rebuilt payload can be validated, invalid ones are dropped.
+			if (_ServerAccept(Index, Payload, PredictionAckWriter)) {
+				Entry.State.Latest = Payload;
+				// Server's own view. (Listen server)
+				ProcessReplicationRequest(Index, Entry.State.Latest);
+			}
+		} else {
+			FNetReplicateTelemetry::RecordDrops(FNetReplicateTelemetry::GetSlot(Entry.Component), 1);
+		}
+	});
+	if (Acks.Num() > 0) {
+		CountRPC(ENetReplicateRPC::OwnerAck, Acks.Num());
+		ClientAck(Acks);
+	}
+	if (PredictionAcks.Num() > 0) {
+		CountRPC(ENetReplicateRPC::PredictionAck, PredictionAcks.Num());
+		ClientPredictionAck(PredictionAcks);
+	}
 }
-bool UNetReplicate::BroadcastMulticastUnreliable_Validate(const FString& ObjectID, const FString& ReplicateData) { 
+bool UNetReplicate::BroadcastServerUnreliable_Validate(const TArray<uint8>& Bundle) {
 	return true;
 }
 
-void UNetReplicate::BroadcastMulticastReliable_Implementation(const FString& ObjectID, const FString& ReplicateData) {
-	ProcessReplicationRequest(ObjectID, ReplicateData);
+void UNetReplicate::ClientAck_Implementation(const TArray<uint8>& Acks) {
+	FMemoryReader Reader(Acks);
+	while (Reader.Tell() < Reader.TotalSize()) {
+		uint32 Index = 0;
+		uint16 Id = 0;
+		Reader.SerializeIntPacked(Index);
+		Reader << Id;
+		if (Reader.IsError() || Index >= (uint32)Entries.Num()) {
+			return;
+		}
+		int32 Lost = Entries[Index].State.ToServer.Ack(Id);
+		if (Lost > 0) {
+			FNetReplicateTelemetry::RecordDrops(FNetReplicateTelemetry::GetSlot(Entries[Index].Component), Lost);
+		}
+	}
 }
-bool UNetReplicate::BroadcastMulticastReliable_Validate(const FString& ObjectID, const FString& ReplicateData) { 
+
+void UNetReplicate::BroadcastServerReliable_Implementation(const TArray<uint8>& Bundle) {
+	TArray<int32, TInlineAllocator<8>> Valid;
+	TArray<uint8> PredictionAcks;
+	FMemoryWriter PredictionAckWriter(PredictionAcks);
+	TArray<uint8> Accepted;
+	_ReadBundle(Bundle, [&](int32 Index, const TArray<uint8>& Payload) {
+		auto& Entry = Entries[Index];
+		Accepted = Payload;
+		if (FNetCompression::Decompress(Accepted) && _ServerAccept(Index, Accepted, PredictionAckWriter)) {
+			Entry.State.Latest = Accepted;
+			Valid.Add(Index);
+			// Server's own view. (Listen server)
+			ProcessReplicationRequest(Index, Entry.State.Latest);
+		}
+	});
+	auto Scheduler = GetWorld()->GetSubsystem<UNetReplicateScheduler>();
+	if (Scheduler && Valid.Num() > 0) {
+		Scheduler->SendReliable(this, Valid);
+	}
+	if (PredictionAcks.Num() > 0) {
+		CountRPC(ENetReplicateRPC::PredictionAck, PredictionAcks.Num());
+		ClientPredictionAck(PredictionAcks);
+	}
+}
+bool UNetReplicate::BroadcastServerReliable_Validate(const TArray<uint8>& Bundle) {
 	return true;
 }
 
-void UNetReplicate::BroadcastServerUnreliable_Implementation(const FString& ObjectID, const FString& ReplicateData) {
-	BroadcastMulticastUnreliable(ObjectID, ReplicateData);
+void UNetReplicate::RequestReplication(int32 NetId, const TArray<uint8>& Payload, bool Reliable) {
+	PCPP_UE4::Network::Local(GetPawnOwner(), [&]() {
+		if (Entries.IsValidIndex(NetId) && Entries[NetId].Component) {
+			auto& Entry = Entries[NetId];
+			Entry.Pending = Payload;
+			Entry.HasPending = true;
+			// A reliable request stays reliable until sent.
+			Entry.PendingReliable |= Reliable;
+		}
+	});
 }
-bool UNetReplicate::BroadcastServerUnreliable_Validate(const FString& ObjectID, const FString& ReplicateData) {
-	return Validate(ObjectID, ReplicateData);
+
+void UNetReplicate::RequestReplication(int32 NetId, const FString& ObjectData, bool Reliable) {
+	TArray<uint8> Payload;
+	_MakeJsonPayload(ObjectData, Payload);
+	RequestReplication(NetId, Payload, Reliable);
 }
 
-void UNetReplicate::BroadcastServerReliable_Implementation(const FString& ObjectID, const FString& ReplicateData) {
-	BroadcastMulticastReliable(ObjectID, ReplicateData);
+void UNetReplicate::_OwnerSend() {
+	double Now = GetWorld()->GetTimeSeconds();
+	TArray<uint8> Reliable;
+	TArray<uint8> Unreliable;
+	FMemoryWriter ReliableWriter(Reliable);
+	FMemoryWriter UnreliableWriter(Unreliable);
+	TArray<uint8> Delta;
+	TArray<uint8> Predicted;
+	TArray<uint8> Compressed;
+
+	for (int32 Index = 0; Index < Entries.Num(); ++Index) {
+		auto& Entry = Entries[Index];
+		// Due, gather the current state.
+		bool Scheduled = false;
+		if (!Entry.HasPending && Entry.Interval > 0.f && Now >= Entry.NextSendTime) {
+			CreatePayload(Entry.Component, Entry.Pending);
+			Entry.HasPending = true;
+			Scheduled = true;
+		}
+		if (!Entry.HasPending) {
+			continue;
+		}
+
+		uint32 Hash = FCrc::MemCrc32(Entry.Pending.GetData(), Entry.Pending.Num());
+		bool Changed = !Entry.Rate.HasHash || Hash != Entry.Rate.LastHash;
+		Entry.Rate.LastHash = Hash;
+		Entry.Rate.HasHash = true;
+		// Forced updates say nothing about the natural change rate.
+		if (Scheduled) {
+			_AdaptInterval(Entry, Changed);
+		}
+		if (Entry.Interval > 0.f) {
+			Entry.NextSendTime = Now + Entry.Interval;
+		}
+
+		// The server learns which step this state follows.
+		const TArray<uint8>* Payload = &Entry.Pending;
+		if (Entry.Predicted) {
+			_AddPredictionHeader(Entry.Prediction, Entry.Pending, Predicted);
+			Payload = &Predicted;
+		}
+
+		if (Entry.PendingReliable) {
+			Compressed = *Payload;
+			FNetCompression::Compress(Compressed, Entry.Component->GetCompressionDictionary());
+			FNetReplicateTelemetry::RecordSend(FNetReplicateTelemetry::GetSlot(Entry.Component), _WriteBundleEntry(ReliableWriter, Index, Compressed), true);
+		}
+		// Nothing is sent while the server has this exact state.
+		else if (Entry.State.ToServer.Encode(*Payload, KeyframeInterval, Delta)) {
+			FNetReplicateTelemetry::RecordSend(FNetReplicateTelemetry::GetSlot(Entry.Component), _WriteBundleEntry(UnreliableWriter, Index, Delta), false);
+		}
+		Entry.HasPending = false;
+		Entry.PendingReliable = false;
+	}
+
+	if (Reliable.Num() > 0) {
+		CountRPC(ENetReplicateRPC::OwnerReliable, Reliable.Num());
+		BroadcastServerReliable(Reliable);
+	}
+	if (Unreliable.Num() > 0) {
+		CountRPC(ENetReplicateRPC::OwnerUnreliable, Unreliable.Num());
+		BroadcastServerUnreliable(Unreliable);
+	}
 }
-bool UNetReplicate::BroadcastServerReliable_Validate(const FString& ObjectID, const FString& ReplicateData) {
-	return Validate(ObjectID, ReplicateData);
+
+void UNetReplicate::_AdaptInterval(FNetReplicateEntry& Entry, bool Changed) {
+	Entry.Rate.Samples++;
+	Entry.Rate.Changes += Changed ? 1 : 0;
+	Entry.Rate.ChangeRate = FMath::Lerp(Entry.Rate.ChangeRate, Changed ? 1.f : 0.f, 0.1f);
+
+	if (AdaptiveReplication) {
+		float Interval = Changed ? Entry.Interval * 0.5f : Entry.Interval * FMath::Max(ReplicationBackoff, 1.f);
+		Entry.Interval = FMath::Clamp(Interval, Entry.MinInterval, Entry.MaxInterval);
+	}
 }
 
-void UNetReplicate::RequestReplication(const FString& ObjectTag, const FString& ObjectData, bool Reliable) {
+void UNetReplicate::_RecordPredictionFromInterface(UActorComponent* Target) {
 	PCPP_UE4::Network::Local(GetPawnOwner(), [&]() {
+		auto Interface = Cast<INetReplicatable>(Target);
+		if (!Interface || !Entries.IsValidIndex(Interface->GetNetId())) {
+			return;
+		}
+		auto& Prediction = Entries[Interface->GetNetId()].Prediction;
+		if (Prediction.History.Num() >= FMath::Max(MaxPredictionHistory, 1)) {
+			Prediction.History.RemoveAt(0, 1, false);
+		}
+		auto& Step = Prediction.History.AddDefaulted_GetRef();
+		Step.Sequence = Prediction.NextSequence++;
+		FMemoryWriter MoveWriter(Step.Move);
+		Interface->SerializePredictionMove(MoveWriter);
+		CreatePayload(Interface, Step.State);
+	});
+}
+
+void UNetReplicate::_AddPredictionHeader(const FNetPredictionState& Prediction, const TArray<uint8>& Payload, TArray<uint8>& Out) {
+	Out.Reset(Payload.Num() + 3);
+	FMemoryWriter Writer(Out);
+	uint8 Flags = (Payload.Num() > 0 ? Payload[0] : 0) | ENetPayloadFlags::Predicted;
+	// Latest recorded step.
+	uint16 Sequence = Prediction.NextSequence - 1;
+	uint8 Epoch = Prediction.Epoch;
+	Writer << Flags << Sequence << Epoch;
+	if (Payload.Num() > 1) {
+		Writer.Serialize(const_cast<uint8*>(Payload.GetData()) + 1, Payload.Num() - 1);
+	}
+}
+
+bool UNetReplicate::_ServerAccept(int32 Index, TArray<uint8>& Payload, FArchive& PredictionAcks) {
+	auto& Entry = Entries[Index];
+	if (!Entry.Predicted) {
+		return Validate(Index, Payload);
+	}
+	if (Payload.Num() < 4 || !(Payload[0] & ENetPayloadFlags::Predicted)) {
+		return false;
+	}
+
+	FMemoryReader Reader(Payload);
+	uint8 Flags = 0;
+	uint16 Sequence = 0;
+	uint8 Epoch = 0;
+	Reader << Flags << Sequence << Epoch;
+	// Clients never see the header.
+	Payload.RemoveAt(1, 3, false);
+	Payload[0] &= ~ENetPayloadFlags::Predicted;
+
+	auto& Prediction = Entry.Prediction;
+	Prediction.LastSequence = Sequence;
+	// Made before the owner applied the latest correction.
+	if (Epoch != Prediction.Epoch) {
+		_WritePredictionAck(PredictionAcks, Index, true);
+		return false;
+	}
+	if (!Validate(Index, Payload)) {
+		// Nothing to correct with yet, the owner keeps trying.
+		if (Entry.State.Latest.Num() > 0) {
+			Prediction.Epoch++;
+			_WritePredictionAck(PredictionAcks, Index, true);
+		}
+		return false;
+	}
+	_WritePredictionAck(PredictionAcks, Index, false);
+	return true;
+}
+
+void UNetReplicate::_WritePredictionAck(FArchive& Ar, int32 Index, bool Corrected) {
+	auto& Entry = Entries[Index];
+	uint32 PackedIndex = Index;
+	uint16 Sequence = Entry.Prediction.LastSequence;
+	uint8 Epoch = Entry.Prediction.Epoch;
+	uint8 CorrectedByte = Corrected ? 1 : 0;
+	Ar.SerializeIntPacked(PackedIndex);
+	Ar << Sequence << Epoch << CorrectedByte;
+	if (Corrected) {
+		uint32 Length = Entry.State.Latest.Num();
+		Ar.SerializeIntPacked(Length);
+		Ar.Serialize(Entry.State.Latest.GetData(), Length);
+	}
+}
+
+void UNetReplicate::ClientPredictionAck_Implementation(const TArray<uint8>& Acks) {
+	FMemoryReader Reader(Acks);
+	TArray<uint8> Authoritative;
+	while (Reader.Tell() < Reader.TotalSize()) {
+		uint32 Index = 0;
+		uint16 Sequence = 0;
+		uint8 Epoch = 0;
+		uint8 Corrected = 0;
+		Reader.SerializeIntPacked(Index);
+		Reader << Sequence << Epoch << Corrected;
+		uint32 Length = 0;
+		if (Corrected) {
+			Reader.SerializeIntPacked(Length);
+		}
+		if (Reader.IsError() || Index >= (uint32)Entries.Num() || Length > (uint32)(Reader.TotalSize() - Reader.Tell())) {
+			return;
+		}
+		Authoritative.SetNumUninitialized(Length);
+		Reader.Serialize(Authoritative.GetData(), Length);
+
+		auto& Entry = Entries[Index];
+		if (!Entry.Predicted) {
+			continue;
+		}
+		auto& Prediction = Entry.Prediction;
+		Prediction.Acks++;
+
+		// A repeated correction that was already applied.
+		if (Corrected && Epoch != Prediction.Epoch) {
+			Prediction.Epoch = Epoch;
+			Prediction.Corrections++;
+			const FNetPredictionStep* Step = Prediction.History.FindByPredicate([Sequence](const FNetPredictionStep& Candidate) {
+				return Candidate.Sequence == Sequence;
+			});
+			float Error = Step ? _PredictionError(Entry.Component, Step->State, Authoritative) : MAX_flt;
+			if (Error > Entry.Component->GetPredictionTolerance()) {
+				_Rewind(Entry, Authoritative, Sequence);
+			}
+		}
+
+		// Acknowledged steps are never replayed again.
+		Prediction.History.RemoveAll([Sequence](const FNetPredictionStep& Step) {
+			return !FNetDelta::IsNewer(Step.Sequence, Sequence);
+		});
+	}
+}
+
+void UNetReplicate::_Rewind(FNetReplicateEntry& Entry, const TArray<uint8>& Authoritative, uint16 Sequence) {
+	auto& Prediction = Entry.Prediction;
+	Prediction.Rewinds++;
+	ApplyPayload(Entry.Component, Authoritative);
+
+	for (auto& Step : Prediction.History) {
+		if (FNetDelta::IsNewer(Step.Sequence, Sequence)) {
+			FMemoryReader MoveReader(Step.Move);
+			Entry.Component->ReplayPrediction(MoveReader);
+			CreatePayload(Entry.Component, Step.State);
+			Prediction.ReplayedSteps++;
+		}
+	}
+
+	// The server gets the reconciled state with the next bundle.
+	CreatePayload(Entry.Component, Entry.Pending);
+	Entry.HasPending = true;
+}
+
+float UNetReplicate::_PredictionError(INetReplicatable* Component, const TArray<uint8>& Predicted, const TArray<uint8>& Authoritative) {
+	if (Predicted == Authoritative) {
+		return 0.f;
+	}
+	if (Predicted.Num() == 0 || Authoritative.Num() == 0 || !(Predicted[0] & Authoritative[0] & ENetPayloadFlags::Binary)) {
+		return MAX_flt;
+	}
+	// Skip the flag bytes.
+	FBitReader PredictedReader(const_cast<uint8*>(Predicted.GetData()) + 1, (Predicted.Num() - 1) * 8);
+	FBitReader AuthoritativeReader(const_cast<uint8*>(Authoritative.GetData()) + 1, (Authoritative.Num() - 1) * 8);
+	return Component->GetPredictionError(PredictedReader, AuthoritativeReader);
+}
+
+void UNetReplicate::ServerCorrect(int32 NetId, const TArray<uint8>& Payload) {
+	if (!GetOwner()->HasAuthority() || !Entries.IsValidIndex(NetId) || !Entries[NetId].Predicted || Payload.Num() == 0) {
+		return;
+	}
+	auto& Entry = Entries[NetId];
+	Entry.State.Latest = Payload;
+	Entry.Prediction.Epoch++;
+	ProcessReplicationRequest(NetId, Entry.State.Latest);
+
+	TArray<uint8> Acks;
+	FMemoryWriter Writer(Acks);
+	_WritePredictionAck(Writer, NetId, true);
+	CountRPC(ENetReplicateRPC::PredictionAck, Acks.Num());
+	ClientPredictionAck(Acks);
+}
+
+const FNetPredictionState* UNetReplicate::GetPredictionState(int32 NetId) const {
+	if (!Entries.IsValidIndex(NetId) || !Entries[NetId].Predicted) {
+		return nullptr;
+	}
+	return &Entries[NetId].Prediction;
+}
+
+bool UNetReplicate::BindChannel(FName Name, bool Reliable, TFunction<void(FArchive&)> Receive, uint16& OutKey) {
+	// FName casing is per process, the lower case string is the same everywhere.
+	uint16 Key = (uint16)FCrc::StrCrc32(*Name.ToString().ToLower());
+	// One channel per name, unbinding a replaced channel would remove its successor.
+	auto Existing = Channels.Find(Key);
+	if (Existing) {
+		UE_LOG(LogTemp, Error, TEXT("NetReplicate %s channel %s collides with %s, rename one of them."), *GetOwner()->GetName(), *Name.ToString(), *Existing->Name.ToString());
+		return false;
+	}
+	Channels.Add(Key, { Name, Reliable, MoveTemp(Receive) });
+	OutKey = Key;
+	return true;
+}
+
+void UNetReplicate::UnbindChannel(uint16 Key) {
+	Channels.Remove(Key);
+}
+
+void UNetReplicate::SendMessage(uint16 Key, const TArray<uint8>& Message) {
+	auto Binding = Channels.Find(Key);
+	bool Local = GetPawnOwner() && GetPawnOwner()->IsLocallyControlled();
+	if (!Binding || !(Local || GetOwner()->HasAuthority())) {
+		return;
+	}
+	FMemoryWriter Writer(QueuedMessages[Binding->Reliable ? 1 : 0], false, true);
+	uint32 Length = Message.Num();
+	Writer << Key;
+	Writer.SerializeIntPacked(Length);
+	Writer.Serialize(const_cast<uint8*>(Message.GetData()), Length);
+}
+
+void UNetReplicate::_FlushMessages() {
+	for (int32 Reliable = 0; Reliable < 2; ++Reliable) {
+		auto& Bundle = QueuedMessages[Reliable];
+		if (Bundle.Num() == 0) {
+			continue;
+		}
+		if (GetOwner()->HasAuthority()) {
+			// Remote owners get what the server sends on their behalf.
+			_ForwardMessages(Bundle, Reliable != 0, !(GetPawnOwner() && GetPawnOwner()->IsLocallyControlled()));
+		} else {
+			CountRPC(ENetReplicateRPC::OwnerMessages, Bundle.Num());
+			if (Reliable) {
+				ServerReliableMessages(Bundle);
+			} else {
+				ServerMessages(Bundle);
+			}
+		}
+		Bundle.Reset();
+	}
+}
+
+void UNetReplicate::_DispatchMessages(const TArray<uint8>& Bundle) {
+	FMemoryReader Reader(Bundle);
+	while (Reader.Tell() < Reader.TotalSize()) {
+		uint16 Key = 0;
+		uint32 Length = 0;
+		Reader << Key;
+		Reader.SerializeIntPacked(Length);
+		if (Reader.IsError() || Length > (uint32)(Reader.TotalSize() - Reader.Tell())) {
+			return;
+		}
+		// Channels not bound here are skipped. Channels without arguments have empty messages.
+		auto Binding = Channels.Find(Key);
+		if (Binding) {
+			FBitReader Message(const_cast<uint8*>(Bundle.GetData()) + Reader.Tell(), Length * 8);
+			Binding->Receive(Message);
+		}
+		Reader.Seek(Reader.Tell() + Length);
+	}
+}
+
+void UNetReplicate::_ForwardMessages(const TArray<uint8>& Bundle, bool Reliable, bool IncludeOwner) {
+	TArray<UNetReplicateConnection*, TInlineAllocator<16>> Targets;
+	for (auto& Weak : RelevantConnections) {
+		if (Weak.IsValid()) {
+			Targets.Add(Weak.Get());
+		}
+	}
+	if (IncludeOwner && GetPawnOwner()) {
+		auto Connection = UNetReplicateConnection::Get(Cast<APlayerController>(GetPawnOwner()->GetController()));
+		if (Connection) {
+			Targets.AddUnique(Connection);
+		}
+	}
+	for (auto Connection : Targets) {
+		CountRPC(ENetReplicateRPC::ServerMessages, Bundle.Num());
 		if (Reliable) {
-			BroadcastServerReliable(ObjectTag, ObjectData);
+			Connection->ClientReceiveReliableMessages(this, Bundle);
+		} else {
+			Connection->ClientReceiveMessages(this, Bundle);
 		}
-		else {
-			BroadcastServerUnreliable(ObjectTag, ObjectData);
+	}
+}
+
+void UNetReplicate::ServerMessages_Implementation(const TArray<uint8>& Bundle) {
+	_DispatchMessages(Bundle);
+	_ForwardMessages(Bundle, false, false);
+}
+bool UNetReplicate::ServerMessages_Validate(const TArray<uint8>& Bundle) {
+	return true;
+}
+
+void UNetReplicate::ServerReliableMessages_Implementation(const TArray<uint8>& Bundle) {
+	_DispatchMessages(Bundle);
+	_ForwardMessages(Bundle, true, false);
+}
+bool UNetReplicate::ServerReliableMessages_Validate(const TArray<uint8>& Bundle) {
+	return true;
+}
+
+void UNetReplicate::ReceiveMessages(const TArray<uint8>& Bundle) {
+	_DispatchMessages(Bundle);
+}
+
+void UNetReplicate::CountRPC(ENetReplicateRPC::Type Type, int32 Bytes) {
+	RPCCounts[Type]++;
+	RPCBytes[Type] += Bytes;
+}
+
+const FNetReplicateRateStats* UNetReplicate::GetRateStats(int32 NetId, float& OutInterval) const {
+	if (!Entries.IsValidIndex(NetId) || !Entries[NetId].Component) {
+		return nullptr;
+	}
+	OutInterval = Entries[NetId].Interval;
+	return &Entries[NetId].Rate;
+}
+
+void UNetReplicate::ReportRates() {
+	for (TObjectIterator<UNetReplicate> It; It; ++It) {
+		if (It->IsTemplate() || !It->GetOwner()) {
+			continue;
+		}
+		for (int32 NetId = 0; NetId < It->Entries.Num(); ++NetId) {
+			auto& Entry = It->Entries[NetId];
+			if (!Entry.Component) {
+				continue;
+			}
+			UE_LOG(LogTemp, Log, TEXT("NetReplicate %s [%d] %s  Interval %.3fs (%.3f - %.3f)  Changed %d / %d  Rate %.2f"),
+				*It->GetOwner()->GetName(), NetId, *Cast<UActorComponent>(Entry.Component)->GetName(),
+				Entry.Interval, Entry.MinInterval, Entry.MaxInterval, Entry.Rate.Changes, Entry.Rate.Samples, Entry.Rate.ChangeRate);
+			if (Entry.Predicted) {
+				UE_LOG(LogTemp, Log, TEXT("NetReplicate %s [%d] Prediction  Acks %d  Corrections %d  Rewinds %d  Replayed %d  Unacknowledged %d"),
+					*It->GetOwner()->GetName(), NetId, Entry.Prediction.Acks, Entry.Prediction.Corrections, Entry.Prediction.Rewinds,
+					Entry.Prediction.ReplayedSteps, Entry.Prediction.History.Num());
+			}
+		}
+	}
+}
+
+void UNetReplicate::ReceiveBundle(UNetReplicateConnection* Connection, const TArray<uint8>& Bundle) {
+	TArray<uint8> Acks;
+	FMemoryWriter AckWriter(Acks);
+	TArray<uint8> Payload;
+	_ReadBundle(Bundle, [&](int32 Index, const TArray<uint8>& Delta) {
+		uint16 Id = 0;
+		if (Entries[Index].State.FromServer.Decode(Delta, Payload, Id)) {
+			_WriteAck(AckWriter, Index, Id);
+			ProcessReplicationRequest(Index, Payload);
+		} else {
+			FNetReplicateTelemetry::RecordDrops(FNetReplicateTelemetry::GetSlot(Entries[Index].Component), 1);
 		}
 	});
+	if (Acks.Num() > 0) {
+		CountRPC(ENetReplicateRPC::ClientAck, Acks.Num());
+		Connection->ServerAck(this, Acks);
+	}
+}
+
+void UNetReplicate::AckBundle(UNetReplicateConnection* Connection, const TArray<uint8>& Acks) {
+	FMemoryReader Reader(Acks);
+	while (Reader.Tell() < Reader.TotalSize()) {
+		uint32 Index = 0;
+		uint16 Id = 0;
+		Reader.SerializeIntPacked(Index);
+		Reader << Id;
+		if (Reader.IsError() || Index >= (uint32)Entries.Num()) {
+			return;
+		}
+		auto ToConnection = Entries[Index].State.ToConnections.Find(Connection);
+		if (ToConnection) {
+			FNetReplicateTelemetry::RecordDrops(FNetReplicateTelemetry::GetSlot(Entries[Index].Component), ToConnection->Sender.Ack(Id));
+		}
+	}
 }
 
 APawn* UNetReplicate::GetPawnOwner() {
 	return PCPP_UE4::LazyGetOwner(this, PawnOwner);
 }
 
-void UNetReplicate::RegisterReplication(float ReplicationFrequency, INetReplicatable* ReplicatingComponent) {
+void UNetReplicate::RegisterReplication(float ReplicationFrequency, INetReplicatable* ReplicatingComponent, float Importance, float MaxInterval) {
 	// Sanity Check, Make sure implementing component is actually a component.
 	auto TargetAsComponent = Cast<UActorComponent>(ReplicatingComponent);
-	if (TargetAsComponent) {
-		// Generate Tag if needed. (Tag is needed for all parties.)
-		ReplicatingComponent->_GetTag();
+	if (TargetAsComponent && TargetAsComponent->GetOwner() == GetOwner()) {
+		// Assign IDs if needed. (IDs are needed for all parties.)
+		int32 NetId = ReplicatingComponent->_NetId;
+		if (!Entries.IsValidIndex(NetId)) {
+			_AssignNetIds();
+			NetId = ReplicatingComponent->_NetId;
+		}
+		auto& Entry = Entries[NetId];
+		if (Entry.Component) {
+			return;
+		}
+		Entry.Component = ReplicatingComponent;
+		Entry.Interval = ReplicationFrequency;
+		Entry.MinInterval = ReplicationFrequency;
+		Entry.MaxInterval = FMath::Max(MaxInterval > 0.f ? MaxInterval : MaxReplicationInterval, ReplicationFrequency);
+		// Some random time between 0 and 1 seconds to spread the first updates.
+		Entry.NextSendTime = GetWorld()->GetTimeSeconds() + FMath::FRand();
+		Entry.Importance = Importance;
+		Entry.Audience = ReplicatingComponent->GetReplicationAudience();
+		Entry.Predicted = ReplicatingComponent->UsesPrediction() && ReplicatingComponent->UsesBinaryReplication();
 
 		// Second Sanity Check, only perform locally
 		PCPP_UE4::Network::Local(GetPawnOwner(), [&]() {
-			// Bind implementation to Implementor
-			ReplicatingComponent->_ReplicationTimerDelegate.BindLambda([&ReplicatingComponent, this]() {
-				// Create heap instance for Shared Pointer through Copy Constructor
-				auto Data = PCPP_UE4::JSON::ToString(ReplicatingComponent->CreateReplicationData());
-
-				this->RequestReplication(ReplicatingComponent->_GetTag(), Data);
-			});
-
-			// Begin Timer Event on Implementor's Behalf
-			GetWorld()->GetTimerManager().SetTimer(
-				ReplicatingComponent->_ReplicationTimerHandle,
-				ReplicatingComponent->_ReplicationTimerDelegate,
-				ReplicationFrequency,
-				(ReplicationFrequency > 0.f), // Only loop if frequency is defined.
-				FMath::FRand()	// Some random time between 0 and 1 seconds to reduce scheduling conflicts.
-			);
-
 			ReplicatingComponent->_ReliableReplicationDelegate.AddDynamic(this, &UNetReplicate::_ProcessReliableRequestFromInterface);
+			if (Entry.Predicted) {
+				ReplicatingComponent->_RecordPredictionDelegate.AddDynamic(this, &UNetReplicate::_RecordPredictionFromInterface);
+			}
 		});
 	}
 }
@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NetReplicateConnection.h"
+#include "NetReplicate.h"
+#include "GameFramework/PlayerController.h"
+
+UNetReplicateConnection::UNetReplicateConnection() {
+	PrimaryComponentTick.bCanEverTick = false;
+	SetIsReplicatedByDefault(true);
+}
+
+UNetReplicateConnection* UNetReplicateConnection::Get(APlayerController* Controller) {
+	if (!Controller) {
+		return nullptr;
+	}
+	auto Connection = Controller->FindComponentByClass<UNetReplicateConnection>();
+	if (!Connection) {
+		// Replicated to the owning client, RPCs sent before it arrives there are dropped and recovered like any lost packet.
+		Connection = NewObject<UNetReplicateConnection>(Controller);
+		Connection->RegisterComponent();
+	}
+	return Connection;
+}
+
+void UNetReplicateConnection::ClientReceiveBundle_Implementation(UNetReplicate* Source, const TArray<uint8>& Bundle) {
+	// The source actor may not have replicated to this client yet.
+	if (Source) {
+		Source->ReceiveBundle(this, Bundle);
+	}
+}
+
+void UNetReplicateConnection::ClientReceiveReliable_Implementation(UNetReplicate* Source, const TArray<uint8>& Bundle) {
+	if (Source) {
+		Source->ReceiveReliable(Bundle);
+	}
+}
+
+void UNetReplicateConnection::ClientReceiveMessages_Implementation(UNetReplicate* Source, const TArray<uint8>& Bundle) {
+	if (Source) {
+		Source->ReceiveMessages(Bundle);
+	}
+}
+
+void UNetReplicateConnection::ClientReceiveReliableMessages_Implementation(UNetReplicate* Source, const TArray<uint8>& Bundle) {
+	if (Source) {
+		Source->ReceiveMessages(Bundle);
+	}
+}
+
+void UNetReplicateConnection::ServerAck_Implementation(UNetReplicate* Source, const TArray<uint8>& Acks) {
+	if (Source) {
+		Source->AckBundle(this, Acks);
+	}
+}
+bool UNetReplicateConnection::ServerAck_Validate(UNetReplicate* Source, const TArray<uint8>& Acks) {
+	return true;
+}
@@ -0,0 +1,329 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NetReplicateScheduler.h"
+#include "NetReplicate.h"
+#include "NetReplicateConnection.h"
+#include "NetReplicateTelemetry.h"
+#include "NetCompression.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/Pawn.h"
+#include "Serialization/MemoryWriter.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<float> CVarPCPPNetBytesPerSecond(
+	TEXT("pcpp.Net.BytesPerSecond"),
+	8000.f,
+	TEXT("UNetReplicate budget (bytes per second) of each connection."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarPCPPNetMaxBurstSeconds(
+	TEXT("pcpp.Net.MaxBurstSeconds"),
+	0.25f,
+	TEXT("Seconds of unspent UNetReplicate budget a connection may save up for a burst."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarPCPPNetSendRate(
+	TEXT("pcpp.Net.SendRate"),
+	20.f,
+	TEXT("UNetReplicate sends per second from the server to each connection."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarPCPPNetRelevancyRadius(
+	TEXT("pcpp.Net.RelevancyRadius"),
+	15000.f,
+	TEXT("Distance (cm) to a connection's view within which UNetReplicate actors become relevant to it. 0 makes every actor relevant."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarPCPPNetRelevancyHysteresis(
+	TEXT("pcpp.Net.RelevancyHysteresis"),
+	0.2f,
+	TEXT("Fraction of pcpp.Net.RelevancyRadius a relevant actor may move beyond it before it stops being relevant."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarPCPPNetDistanceScale(
+	TEXT("pcpp.Net.DistanceScale"),
+	5000.f,
+	TEXT("Distance (cm) to a connection's view at which UNetReplicate updates lose half their score."),
+	ECVF_Default);
+
+// Score gained per second an update goes unsent, relative to its base score.
+static const float NetStalenessWeight = 2.f;
+
+// Bundle entry header, a rough estimate of the packed index and length.
+static const float NetEntryOverhead = 2.f;
+
+UNetReplicateScheduler::UNetReplicateScheduler() {
+	Accumulator = 0.f;
+}
+
+void UNetReplicateScheduler::Register(UNetReplicate* Source) {
+	Sources.AddUnique(Source);
+}
+
+void UNetReplicateScheduler::Unregister(UNetReplicate* Source) {
+	Sources.RemoveSwap(Source);
+}
+
+float UNetReplicateScheduler::ComputeScore(UNetReplicate* Source, int32 Index, const FVector& ViewLocation) {
+	auto& Entry = Source->Entries[Index];
+	float Score = Source->GetOwner()->NetPriority * Entry.Importance;
+
+	float Scale = FMath::Max(CVarPCPPNetDistanceScale.GetValueOnGameThread(), 1.f);
+	float Distance = FVector::Dist(ViewLocation, Source->GetOwner()->GetActorLocation());
+	Score *= Scale / (Scale + Distance);
+
+	return Score;
+}
+
+bool UNetReplicateScheduler::CanReceive(UNetReplicate* Source, int32 Index, const FName& ViewerTeam) {
+	switch (Source->Entries[Index].Audience) {
+	case ENetReplicationAudience::OwnerOnly:
+		// The owner is never sent its own state.
+		return false;
+	case ENetReplicationAudience::TeamOnly:
+		return !ViewerTeam.IsNone() && ViewerTeam == Source->NetTeam;
+	default:
+		return true;
+	}
+}
+
+FName UNetReplicateScheduler::GetTeam(AController* Controller) {
+	if (Controller && TeamResolver.IsBound()) {
+		return TeamResolver.Execute(Controller);
+	}
+	return NAME_None;
+}
+
+void UNetReplicateScheduler::GatherViewers(float CellSize) {
+	Viewers.Reset();
+	Grid.Reset();
+	for (auto It = GetWorld()->GetPlayerControllerIterator(); It; ++It) {
+		APlayerController* Controller = It->Get();
+		// Local controllers see the server's state directly.
+		if (!Controller || Controller->IsLocalController()) {
+			continue;
+		}
+		FNetReplicateViewer Viewer;
+		Viewer.Connection = UNetReplicateConnection::Get(Controller);
+		Viewer.Controller = Controller;
+		FRotator ViewRotation;
+		Controller->GetPlayerViewPoint(Viewer.Location, ViewRotation);
+		Viewer.Team = GetTeam(Controller);
+		int32 Index = Viewers.Add(Viewer);
+		if (CellSize > 0.f) {
+			Grid.FindOrAdd(FIntPoint(FMath::FloorToInt(Viewer.Location.X / CellSize), FMath::FloorToInt(Viewer.Location.Y / CellSize))).Add(Index);
+		}
+	}
+}
+
+void UNetReplicateScheduler::UpdateRelevancy(UNetReplicate* Source, float Radius, float CellSize) {
+	auto Pawn = Source->GetPawnOwner();
+	AController* OwningController = Pawn ? Pawn->GetController() : nullptr;
+	Source->NetTeam = GetTeam(OwningController);
+
+	FVector Location = Source->GetOwner()->GetActorLocation();
+	TSet<TWeakObjectPtr<UNetReplicateConnection>> Relevant;
+	auto Consider = [&](const FNetReplicateViewer& Viewer) {
+		// The owner knows its own state.
+		if (Viewer.Controller == OwningController) {
+			return;
+		}
+		bool Was = Source->RelevantConnections.Contains(Viewer.Connection);
+		float DistanceSquared = FVector::DistSquared(Location, Viewer.Location);
+		// Already relevant actors stay relevant up to the cell size. (Hysteresis)
+		if (Radius <= 0.f || DistanceSquared <= FMath::Square(Was ? CellSize : Radius)) {
+			Relevant.Add(Viewer.Connection);
+			if (!Was) {
+				// The client may have dropped the actor meanwhile.
+				for (auto& Entry : Source->Entries) {
+					auto ToConnection = Entry.State.ToConnections.Find(Viewer.Connection);
+					if (ToConnection) {
+						ToConnection->Sender.ForceKeyframe();
+					}
+				}
+			}
+		}
+	};
+
+	if (Radius <= 0.f) {
+		for (auto& Viewer : Viewers) {
+			Consider(Viewer);
+		}
+	} else {
+		// Cells are as large as the exit radius, the neighbouring cells hold every candidate.
+		FIntPoint Cell(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+		for (int32 X = -1; X <= 1; ++X) {
+			for (int32 Y = -1; Y <= 1; ++Y) {
+				auto Found = Grid.Find(Cell + FIntPoint(X, Y));
+				if (Found) {
+					for (int32 Index : *Found) {
+						Consider(Viewers[Index]);
+					}
+				}
+			}
+		}
+	}
+	Source->RelevantConnections = MoveTemp(Relevant);
+}
+
+void UNetReplicateScheduler::SendReliable(UNetReplicate* Source, const TArray<int32, TInlineAllocator<8>>& Indices) {
+	// Compressed once for every connection.
+	TArray<TArray<uint8>, TInlineAllocator<8>> Payloads;
+	for (int32 Index : Indices) {
+		auto& Entry = Source->Entries[Index];
+		auto& Payload = Payloads.Add_GetRef(Entry.State.Latest);
+		FNetCompression::Compress(Payload, Entry.Component ? Entry.Component->GetCompressionDictionary() : 0);
+	}
+
+	double Now = GetWorld()->GetTimeSeconds();
+	TArray<uint8> Bundle;
+	for (auto& Weak : Source->RelevantConnections) {
+		auto Connection = Weak.Get();
+		if (!Connection) {
+			continue;
+		}
+		FName Team = GetTeam(Cast<AController>(Connection->GetOwner()));
+		Bundle.Reset();
+		FMemoryWriter Writer(Bundle);
+		for (int32 i = 0; i < Indices.Num(); ++i) {
+			int32 Index = Indices[i];
+			if (CanReceive(Source, Index, Team)) {
+				FNetReplicateTelemetry::RecordSend(FNetReplicateTelemetry::GetSlot(Source->Entries[Index].Component), UNetReplicate::_WriteBundleEntry(Writer, Index, Payloads[i]), true);
+			}
+		}
+		if (Bundle.Num() > 0) {
+			UNetReplicate::CountRPC(ENetReplicateRPC::ServerReliable, Bundle.Num());
+			Connection->ClientReceiveReliable(Source, Bundle);
+			// The connection will have these payloads, SendTo must not send them again.
+			for (int32 Index : Indices) {
+				if (CanReceive(Source, Index, Team)) {
+					auto& State = Source->Entries[Index].State;
+					auto& ToConnection = State.ToConnections.FindOrAdd(Connection);
+					ToConnection.Sender.Deliver(State.Latest);
+					ToConnection.LastSendTime = Now;
+				}
+			}
+		}
+	}
+}
+
+void UNetReplicateScheduler::SendTo(const FNetReplicateViewer& Viewer, float Seconds, double Now) {
+	UNetReplicateConnection* Connection = Viewer.Connection;
+	float BytesPerSecond = CVarPCPPNetBytesPerSecond.GetValueOnGameThread();
+	float& Budget = Credit.FindOrAdd(Connection);
+	Budget = FMath::Min(Budget + BytesPerSecond * Seconds, BytesPerSecond * CVarPCPPNetMaxBurstSeconds.GetValueOnGameThread());
+	if (Budget <= 0.f) {
+		return;
+	}
+
+	// Everything the connection is missing.
+	Candidates.Reset();
+	for (auto& Weak : Sources) {
+		auto Source = Weak.Get();
+		if (!Source || !Source->RelevantConnections.Contains(Connection)) {
+			continue;
+		}
+		for (int32 Index = 0; Index < Source->Entries.Num(); ++Index) {
+			auto& State = Source->Entries[Index].State;
+			if (State.Latest.Num() == 0 || !CanReceive(Source, Index, Viewer.Team)) {
+				continue;
+			}
+			auto& ToConnection = State.ToConnections.FindOrAdd(Connection);
+			if (ToConnection.Sender.IsAcknowledged(State.Latest)) {
+				continue;
+			}
+			// Staleness lets low scores eventually climb above the cut.
+			float Staleness = (float)(Now - ToConnection.LastSendTime);
+			float Score = ComputeScore(Source, Index, Viewer.Location) * (1.f + Staleness * NetStalenessWeight);
+			Candidates.Add({ Source, Index, Score });
+		}
+	}
+	Candidates.Sort([](const FNetReplicateCandidate& A, const FNetReplicateCandidate& B) {
+		return A.Score > B.Score;
+	});
+
+	// Spend the budget in order of score, one bundle per actor. The last update may overdraw, the debt is paid from the next sends.
+	TArray<TPair<UNetReplicate*, TArray<uint8>>, TInlineAllocator<16>> Bundles;
+	TArray<uint8> Delta;
+	for (auto It = Candidates.CreateConstIterator(); It && Budget > 0.f; ++It) {
+		auto& State = It->Source->Entries[It->Index].State;
+		auto& ToConnection = State.ToConnections.FindOrAdd(Connection);
+		if (!ToConnection.Sender.Encode(State.Latest, It->Source->KeyframeInterval, Delta)) {
+			continue;
+		}
+		ToConnection.LastSendTime = Now;
+		Budget -= Delta.Num() + NetEntryOverhead;
+
+		auto Bundle = Bundles.FindByPredicate([&It](const TPair<UNetReplicate*, TArray<uint8>>& Pair) {
+			return Pair.Key == It->Source;
+		});
+		if (!Bundle) {
+			Bundle = &Bundles[Bundles.Emplace(It->Source, TArray<uint8>())];
+		}
+		FMemoryWriter Writer(Bundle->Value, false, true);
+		int32 Bytes = UNetReplicate::_WriteBundleEntry(Writer, It->Index, Delta);
+		FNetReplicateTelemetry::RecordSend(FNetReplicateTelemetry::GetSlot(It->Source->Entries[It->Index].Component), Bytes, false);
+	}
+
+	for (auto& Bundle : Bundles) {
+		UNetReplicate::CountRPC(ENetReplicateRPC::ServerUnreliable, Bundle.Value.Num());
+		Connection->ClientReceiveBundle(Bundle.Key, Bundle.Value);
+	}
+}
+
+void UNetReplicateScheduler::Tick(float DeltaTime) {
+	Accumulator += DeltaTime;
+	float Interval = 1.f / FMath::Max(CVarPCPPNetSendRate.GetValueOnGameThread(), 1.f);
+	if (Accumulator < Interval) {
+		return;
+	}
+	float Seconds = Accumulator;
+	Accumulator = 0.f;
+
+	// Drop anything that was destroyed without unregistering.
+	Sources.RemoveAllSwap([](const TWeakObjectPtr<UNetReplicate>& Source) {
+		return !Source.IsValid();
+	});
+
+	float Radius = CVarPCPPNetRelevancyRadius.GetValueOnGameThread();
+	float CellSize = Radius * (1.f + FMath::Max(CVarPCPPNetRelevancyHysteresis.GetValueOnGameThread(), 0.f));
+	GatherViewers(CellSize);
+	for (auto& Source : Sources) {
+		UpdateRelevancy(Source.Get(), Radius, CellSize);
+	}
+
+	double Now = GetWorld()->GetTimeSeconds();
+	for (auto& Viewer : Viewers) {
+		SendTo(Viewer, Seconds, Now);
+	}
+
+	// Forget connections that are gone.
+	for (auto Budget = Credit.CreateIterator(); Budget; ++Budget) {
+		if (!Budget->Key.IsValid()) {
+			Budget.RemoveCurrent();
+		}
+	}
+	for (auto& Weak : Sources) {
+		auto Source = Weak.Get();
+		if (!Source) {
+			continue;
+		}
+		for (auto& Entry : Source->Entries) {
+			for (auto ToConnection = Entry.State.ToConnections.CreateIterator(); ToConnection; ++ToConnection) {
+				if (!ToConnection->Key.IsValid()) {
+					ToConnection.RemoveCurrent();
+				}
+			}
+		}
+	}
+}
+
+bool UNetReplicateScheduler::IsTickable() const {
+	return Sources.Num() > 0;
+}
+
+TStatId UNetReplicateScheduler::GetStatId() const {
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UNetReplicateScheduler, STATGROUP_Tickables);
+}
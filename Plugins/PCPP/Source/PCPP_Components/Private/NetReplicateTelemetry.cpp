@@ -0,0 +1,223 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NetReplicateTelemetry.h"
+#include "NetReplicatable.h"
+#include "Components/ActorComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+
+CSV_DEFINE_CATEGORY(PCPPNetReplicate, true);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sends"), STAT_PCPPNetSends, STATGROUP_PCPPNetReplicate);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Bytes"), STAT_PCPPNetBytes, STATGROUP_PCPPNetReplicate);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Drops"), STAT_PCPPNetDrops, STATGROUP_PCPPNetReplicate);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Serialize (ms)"), STAT_PCPPNetSerializeMs, STATGROUP_PCPPNetReplicate);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Apply (ms)"), STAT_PCPPNetApplyMs, STATGROUP_PCPPNetReplicate);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Classes"), STAT_PCPPNetClasses, STATGROUP_PCPPNetReplicate);
+
+static TAutoConsoleVariable<int32> CVarPCPPNetTelemetry(
+	TEXT("pcpp.Net.Telemetry"),
+	0,
+	TEXT("Record UNetReplicate payload sizes, sends, drops and serialization time per component class."),
+	ECVF_Default);
+
+static FAutoConsoleCommand CmdPCPPNetTelemetryTop(
+	TEXT("pcpp.Net.TelemetryTop"),
+	TEXT("Logs the N (10) component classes costing the most. Sorted by Bytes (default), Sends, Drops or Serialize."),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&FNetReplicateTelemetry::Top));
+
+static FAutoConsoleCommand CmdPCPPNetTelemetryHistogram(
+	TEXT("pcpp.Net.TelemetryHistogram"),
+	TEXT("Logs the recent payload size histogram of every component class containing Filter."),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&FNetReplicateTelemetry::Histogram));
+
+static FAutoConsoleCommand CmdPCPPNetTelemetryReset(
+	TEXT("pcpp.Net.TelemetryReset"),
+	TEXT("Drops every UNetReplicate telemetry record."),
+	FConsoleCommandDelegate::CreateStatic(&FNetReplicateTelemetry::Reset));
+
+static const TCHAR* NetTelemetryBucketNames[] = {
+	TEXT("<=8"),
+	TEXT("<=16"),
+	TEXT("<=32"),
+	TEXT("<=64"),
+	TEXT("<=128"),
+	TEXT("<=256"),
+	TEXT("<=512"),
+	TEXT("<=1024"),
+	TEXT(">1024")
+};
+
+TArray<FNetTelemetryRecord> FNetReplicateTelemetry::Records;
+TMap<TPair<const UClass*, FName>, int32> FNetReplicateTelemetry::Slots;
+
+bool FNetReplicateTelemetry::IsEnabled() {
+	return CVarPCPPNetTelemetry.GetValueOnGameThread() != 0;
+}
+
+int32 FNetReplicateTelemetry::GetSlot(INetReplicatable* Component) {
+	auto AsComponent = Cast<UActorComponent>(Component);
+	if (!AsComponent || !IsEnabled()) {
+		return INDEX_NONE;
+	}
+	FName Tag = AsComponent->ComponentTags.Num() > 0 ? AsComponent->ComponentTags[0] : NAME_None;
+	TPair<const UClass*, FName> Key(AsComponent->GetClass(), Tag);
+	if (auto Found = Slots.Find(Key)) {
+		return *Found;
+	}
+
+	int32 Slot = Records.AddDefaulted();
+	auto& Record = Records[Slot];
+	Record.Name = Tag.IsNone() ? AsComponent->GetClass()->GetName() : FString::Printf(TEXT("%s.%s"), *AsComponent->GetClass()->GetName(), *Tag.ToString());
+	Record.CsvBytesName = FName(*FString::Printf(TEXT("%sBytes"), *Record.Name));
+	Slots.Add(Key, Slot);
+	INC_DWORD_STAT(STAT_PCPPNetClasses);
+	return Slot;
+}
+
+void FNetReplicateTelemetry::RecordSend(int32 Slot, int32 Bytes, bool Reliable) {
+	if (!Records.IsValidIndex(Slot)) {
+		return;
+	}
+	auto& Record = Records[Slot];
+	Record.Sends++;
+	Record.ReliableSends += Reliable ? 1 : 0;
+	Record.Bytes += Bytes;
+
+	INC_DWORD_STAT(STAT_PCPPNetSends);
+	INC_DWORD_STAT_BY(STAT_PCPPNetBytes, Bytes);
+	CSV_CUSTOM_STAT(PCPPNetReplicate, Sends, 1, ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(PCPPNetReplicate, Bytes, Bytes, ECsvCustomStatOp::Accumulate);
+#if CSV_PROFILER
+	FCsvProfiler::RecordCustomStat(Record.CsvBytesName, CSV_CATEGORY_INDEX(PCPPNetReplicate), Bytes, ECsvCustomStatOp::Accumulate);
+#endif
+}
+
+void FNetReplicateTelemetry::RecordDrops(int32 Slot, int32 Count) {
+	if (!Records.IsValidIndex(Slot) || Count <= 0) {
+		return;
+	}
+	Records[Slot].Drops += Count;
+	INC_DWORD_STAT_BY(STAT_PCPPNetDrops, Count);
+	CSV_CUSTOM_STAT(PCPPNetReplicate, Drops, Count, ECsvCustomStatOp::Accumulate);
+}
+
+void FNetReplicateTelemetry::RecordSerialize(int32 Slot, uint64 Cycles, int32 PayloadSize) {
+	if (!Records.IsValidIndex(Slot)) {
+		return;
+	}
+	auto& Record = Records[Slot];
+	Record.Serializes++;
+	Record.SerializeCycles += Cycles;
+	Record.Sizes[Record.Head] = (uint16)FMath::Min(PayloadSize, (int32)MAX_uint16);
+	Record.Head = (Record.Head + 1) % FNetTelemetryRecord::MaxSamples;
+	Record.Count = FMath::Min(Record.Count + 1, FNetTelemetryRecord::MaxSamples);
+
+	float Milliseconds = (float)FPlatformTime::ToMilliseconds64(Cycles);
+	INC_FLOAT_STAT_BY(STAT_PCPPNetSerializeMs, Milliseconds);
+	CSV_CUSTOM_STAT(PCPPNetReplicate, SerializeMs, Milliseconds, ECsvCustomStatOp::Accumulate);
+}
+
+void FNetReplicateTelemetry::RecordApply(int32 Slot, uint64 Cycles) {
+	if (!Records.IsValidIndex(Slot)) {
+		return;
+	}
+	auto& Record = Records[Slot];
+	Record.Applies++;
+	Record.ApplyCycles += Cycles;
+
+	float Milliseconds = (float)FPlatformTime::ToMilliseconds64(Cycles);
+	INC_FLOAT_STAT_BY(STAT_PCPPNetApplyMs, Milliseconds);
+	CSV_CUSTOM_STAT(PCPPNetReplicate, ApplyMs, Milliseconds, ECsvCustomStatOp::Accumulate);
+}
+
+const FNetTelemetryRecord* FNetReplicateTelemetry::GetRecord(int32 Slot) {
+	return Records.IsValidIndex(Slot) ? &Records[Slot] : nullptr;
+}
+
+void FNetReplicateTelemetry::GetHistogram(int32 Slot, int32 (&OutBuckets)[NumBuckets]) {
+	FMemory::Memzero(OutBuckets);
+	if (!Records.IsValidIndex(Slot)) {
+		return;
+	}
+	const auto& Record = Records[Slot];
+	for (int32 i = 0; i < Record.Count; ++i) {
+		// 0-8 -> 0, 9-16 -> 1, ...
+		int32 Bucket = Record.Sizes[i] <= 8 ? 0 : (int32)FMath::CeilLogTwo(Record.Sizes[i]) - 3;
+		OutBuckets[FMath::Min(Bucket, NumBuckets - 1)]++;
+	}
+}
+
+int32 FNetReplicateTelemetry::GetSizePercentile(int32 Slot, float Percent) {
+	if (!Records.IsValidIndex(Slot) || Records[Slot].Count == 0) {
+		return 0;
+	}
+	const auto& Record = Records[Slot];
+	uint16 Sorted[FNetTelemetryRecord::MaxSamples];
+	FMemory::Memcpy(Sorted, Record.Sizes, Record.Count * sizeof(uint16));
+	Sort(Sorted, Record.Count);
+	return Sorted[FMath::Clamp(FMath::CeilToInt(Percent / 100.f * Record.Count) - 1, 0, Record.Count - 1)];
+}
+
+void FNetReplicateTelemetry::Top(const TArray<FString>& Args) {
+	int32 N = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 10;
+	FString By = Args.Num() > 1 ? Args[1] : TEXT("Bytes");
+
+	TArray<int32> Order;
+	for (int32 Slot = 0; Slot < Records.Num(); ++Slot) {
+		Order.Add(Slot);
+	}
+	auto Value = [&By](const FNetTelemetryRecord& Record) -> double {
+		if (By == TEXT("Sends")) {
+			return (double)Record.Sends;
+		}
+		if (By == TEXT("Drops")) {
+			return (double)Record.Drops;
+		}
+		if (By == TEXT("Serialize")) {
+			return (double)Record.SerializeCycles;
+		}
+		return (double)Record.Bytes;
+	};
+	Order.Sort([&](int32 A, int32 B) {
+		return Value(Records[A]) > Value(Records[B]);
+	});
+
+	if (!IsEnabled()) {
+		UE_LOG(LogTemp, Log, TEXT("NetTelemetry is disabled, enable it with pcpp.Net.Telemetry 1"));
+	}
+	for (int32 i = 0; i < FMath::Min(N, Order.Num()); ++i) {
+		const auto& Record = Records[Order[i]];
+		UE_LOG(LogTemp, Log, TEXT("NetTelemetry %-40s Bytes %10lld  Sends %8lld (Reliable %lld)  Avg %6.1fB  Drops %6lld  Serialize %7.2fus  Apply %7.2fus  Size P50 %d P95 %d"),
+			*Record.Name, Record.Bytes, Record.Sends, Record.ReliableSends,
+			Record.Sends > 0 ? (double)Record.Bytes / Record.Sends : 0.0,
+			Record.Drops,
+			Record.Serializes > 0 ? FPlatformTime::ToMilliseconds64(Record.SerializeCycles) * 1000.0 / Record.Serializes : 0.0,
+			Record.Applies > 0 ? FPlatformTime::ToMilliseconds64(Record.ApplyCycles) * 1000.0 / Record.Applies : 0.0,
+			GetSizePercentile(Order[i], 50.f), GetSizePercentile(Order[i], 95.f));
+	}
+}
+
+void FNetReplicateTelemetry::Histogram(const TArray<FString>& Args) {
+	FString Filter = Args.Num() > 0 ? Args[0] : FString();
+	for (int32 Slot = 0; Slot < Records.Num(); ++Slot) {
+		const auto& Record = Records[Slot];
+		if (!Filter.IsEmpty() && !Record.Name.Contains(Filter)) {
+			continue;
+		}
+		int32 Buckets[NumBuckets];
+		GetHistogram(Slot, Buckets);
+		UE_LOG(LogTemp, Log, TEXT("NetTelemetry %s  Last %d payloads"), *Record.Name, Record.Count);
+		for (int32 i = 0; i < NumBuckets; ++i) {
+			int32 Bar = Record.Count > 0 ? FMath::RoundToInt(40.f * Buckets[i] / Record.Count) : 0;
+			UE_LOG(LogTemp, Log, TEXT("  %7s %4d %s"), NetTelemetryBucketNames[i], Buckets[i], *FString::ChrN(Bar, TEXT('#')));
+		}
+	}
+}
+
+void FNetReplicateTelemetry::Reset() {
+	Records.Reset();
+	Slots.Reset();
+	SET_DWORD_STAT(STAT_PCPPNetClasses, 0);
+}
@@ -4,6 +4,22 @@
 #include "PollingClientComponent.h"
 #include "GameFramework/GameModeBase.h"
 #include "PCPP_UE4.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<float> CVarPCPPPollTimeout(
+	TEXT("pcpp.Poll.Timeout"),
+	5.f,
+	TEXT("Seconds a UPollingClientComponent poll waits for its response unless given a timeout. 0 waits forever."),
+	ECVF_Default);
+
+// Callback setting a promise, the future of which is returned.
+static FPollCallback MakePollPromise(TFuture<FPollResult>& OutFuture) {
+	TSharedRef<TPromise<FPollResult>> Promise = MakeShared<TPromise<FPollResult>>();
+	OutFuture = Promise->GetFuture();
+	return [Promise](const FPollResult& Result) {
+		Promise->SetValue(Result);
+	};
+}
 
 TArray<UPollingClientComponent*> UPollingClientComponent::_Pollers = {};
 
@@ -12,10 +28,13 @@ UPollingClientComponent::UPollingClientComponent()
 {
 	// Set this component to be initialized when the game starts, and to be ticked every frame.  You can turn these features
 	// off to improve performance if you don't need them.
-	PrimaryComponentTick.bCanEverTick = false;
+	PrimaryComponentTick.bCanEverTick = true;
+	// Only ticks while polls are pending, to time them out.
+	PrimaryComponentTick.bStartWithTickEnabled = false;
 
 	_PollingMode = EPollingMode::NoPoll;
 	_Implementation = nullptr;
+	_LastRequestId = 0;
 
 	SetIsReplicatedByDefault(true);
 	// ...
@@ -74,77 +93,237 @@ void UPollingClientComponent::BeginPlay()
 	
 }
 
-void UPollingClientComponent::ServerReceiveResponse_Implementation(const FString& Endpoint, const FString& Data, UPollingClientComponent* Caller) {
-	if (_Implementation) {
-		FJsonObject ResponseObject;
-		bool ObjectMade = PCPP_UE4::JSON::ToObject(Data, ResponseObject);
-		if (ObjectMade) {
-			_Implementation->ServerGetResponse(Endpoint, ResponseObject, Caller);
+void UPollingClientComponent::EndPlay(const EEndPlayReason::Type EndPlayReason) {
+	// Nobody is left to answer or wait.
+	TArray<uint32> RequestIds;
+	_Pending.GetKeys(RequestIds);
+	for (auto RequestId : RequestIds) {
+		_Resolve(RequestId, EPollStatus::Cancelled, FJsonObject(), nullptr);
+	}
+	_Pollers.Remove(this);
+	Super::EndPlay(EndPlayReason);
+}
+
+uint32 UPollingClientComponent::_Send(UPollingClientComponent* Target, const FString& Endpoint, float Timeout, FPollCallback Callback) {
+	// Confirm that code is being run on Client / Server
+	bool IsClient = GetWorld()->IsNetMode(NM_Client);
+	bool CanSend = Target
+		? _PollingMode == EPollingMode::IsServer && !IsClient && Target->_PollingMode == EPollingMode::IsClient
+		: _PollingMode == EPollingMode::IsClient && IsClient;
+	if (!CanSend) {
+		if (Callback) {
+			FPollResult Result;
+			Result.Endpoint = Endpoint;
+			Callback(Result);
 		}
+		return 0;
+	}
+
+	if (++_LastRequestId == 0) {
+		++_LastRequestId;
 	}
+	Timeout = Timeout < 0.f ? CVarPCPPPollTimeout.GetValueOnGameThread() : Timeout;
+
+	FPendingPoll Pending;
+	Pending.Endpoint = Endpoint;
+	// Server polls are answered to this component.
+	Pending.Target = Target ? Target : this;
+	Pending.SentTime = FPlatformTime::Seconds();
+	Pending.Deadline = Timeout > 0.f ? Pending.SentTime + Timeout : 0.0;
+	Pending.Callback = MoveTemp(Callback);
+	_Pending.Add(_LastRequestId, MoveTemp(Pending));
+	SetComponentTickEnabled(true);
+
+	if (Target) {
+		// EXECUTING ON SERVER, ATTEMPTING TO POLL CLIENT
+		Target->ClientPolled(_LastRequestId, Endpoint);
+	} else {
+		// EXECUTING ON CLIENT, ATTEMPTING TO POLL SERVER
+		ServerPolled(_LastRequestId, Endpoint);
+	}
+	return _LastRequestId;
 }
 
+void UPollingClientComponent::_ReceiveResponse(uint32 RequestId, const FString& Data, UPollingClientComponent* Responder) {
+	auto Pending = _Pending.Find(RequestId);
+	if (!Pending || Pending->Target.Get() != Responder) {
+		UE_LOG(LogTemp, Verbose, TEXT("Poller dropped response %u, it timed out or was never requested"), RequestId);
+		return;
+	}
+
+	FJsonObject ResponseObject;
+	bool ObjectMade = PCPP_UE4::JSON::ToObject(Data, ResponseObject);
+	if (Pending->Callback) {
+		_Resolve(RequestId, ObjectMade ? EPollStatus::Answered : EPollStatus::Malformed, ResponseObject, Responder);
+		return;
+	}
 
-void UPollingClientComponent::ClientReceiveResponse_Implementation(const FString& Endpoint, const FString& Data) {
-	if (_Implementation) {
-		FJsonObject ResponseObject;
-		bool ObjectMade = PCPP_UE4::JSON::ToObject(Data, ResponseObject);
-		if (ObjectMade) {
+	// TryPoll, respond through the implementation.
+	FString Endpoint = Pending->Endpoint;
+	_Pending.Remove(RequestId);
+	if (_Implementation && ObjectMade) {
+		if (_PollingMode == EPollingMode::IsServer) {
+			_Implementation->ServerGetResponse(Endpoint, ResponseObject, Responder);
+		} else {
 			_Implementation->ClientGetResponse(Endpoint, ResponseObject);
 		}
 	}
 }
 
-void UPollingClientComponent::ServerPolled_Implementation(const FString & Endpoint, UPollingClientComponent * Caller) {
+void UPollingClientComponent::_Resolve(uint32 RequestId, EPollStatus Status, const FJsonObject& Response, UPollingClientComponent* Responder) {
+	// Removed first, the callback may poll again.
+	FPendingPoll Pending;
+	if (!_Pending.RemoveAndCopyValue(RequestId, Pending)) {
+		return;
+	}
+	if (!Pending.Callback) {
+		if (Status != EPollStatus::Answered) {
+			UE_LOG(LogTemp, Verbose, TEXT("Poll %u of %s was not answered (%d)"), RequestId, *Pending.Endpoint, (int32)Status);
+		}
+		return;
+	}
+
+	FPollResult Result;
+	Result.RequestId = RequestId;
+	Result.Status = Status;
+	Result.Endpoint = Pending.Endpoint;
+	if (Status == EPollStatus::Answered) {
+		Result.Response = Response;
+	}
+	Result.Responder = Responder;
+	Result.Latency = (float)(FPlatformTime::Seconds() - Pending.SentTime);
+	Pending.Callback(Result);
+}
+
+FString UPollingClientComponent::_MakeResponse(const FString& Endpoint) {
+	auto ResponseObject = _Implementation->MakeResponseObject(Endpoint);
+	return PCPP_UE4::JSON::ToString(ResponseObject);
+}
+
+void UPollingClientComponent::ServerReceiveResponse_Implementation(uint32 RequestId, const FString& Data) {
+	// Data received from client, but executing on server. So GameMode exists in this context.
+	auto GameMode = GetWorld()->GetAuthGameMode();
+	if (GameMode) {
+		auto Comp = Cast<UPollingClientComponent>(GameMode->GetComponentByClass(UPollingClientComponent::StaticClass()));
+		if (Comp) {
+			// Because the client was polled, the server should receive the response.
+			Comp->_ReceiveResponse(RequestId, Data, this);
+		}
+	}
+}
+
+void UPollingClientComponent::ClientReceiveResponse_Implementation(uint32 RequestId, const FString& Data) {
+	_ReceiveResponse(RequestId, Data, this);
+}
+
+void UPollingClientComponent::ServerPolled_Implementation(uint32 RequestId, const FString& Endpoint) {
 	if (_Implementation) {
-		auto ResponseObject = _Implementation->MakeResponseObject(Endpoint);
-		auto ResponseString = PCPP_UE4::JSON::ToString(ResponseObject);
 		// Send data from server back to the caller.
-		Caller->ClientReceiveResponse(Endpoint, ResponseString);
+		ClientReceiveResponse(RequestId, _MakeResponse(Endpoint));
 	}
 }
 
-void UPollingClientComponent::ClientPolled_Implementation(const FString & Endpoint) {
+void UPollingClientComponent::ClientPolled_Implementation(uint32 RequestId, const FString& Endpoint) {
 	if (_Implementation) {
-		auto ResponseObject = _Implementation->MakeResponseObject(Endpoint);
-		auto ResponseString = PCPP_UE4::JSON::ToString(ResponseObject);
-
-		// Data received from client, but executing on server. So GameMode exists in this context.
-		auto GameMode = GetWorld()->GetAuthGameMode();
-		if (GameMode) {
-			auto Comp = Cast<UPollingClientComponent>(GameMode->GetComponentByClass(UPollingClientComponent::StaticClass()));
-			if (Comp) {
-				// Because the client was polled, the server should receive the response.
-				Comp->ServerReceiveResponse(Endpoint, ResponseString, this);
-			}
-		}
+		ServerReceiveResponse(RequestId, _MakeResponse(Endpoint));
 	}
 }
 
 void UPollingClientComponent::TryPoll(const FString Endpoint) {
-	// Confirm that code is being run on Client / Server
-	bool IsClient = GetWorld()->IsNetMode(NM_Client);
-
 	// Sanity Check, don't attempt to poll if an implementation doesn't exist.
 	if (_Implementation) {
-		if (_PollingMode == EPollingMode::IsClient && IsClient) {
-			// EXECUTING ON CLIENT, ATTEMPTING TO POLL SERVER
+		if (_PollingMode == EPollingMode::IsClient) {
 			// POLL SERVER
-			ServerPolled(Endpoint, this);
+			_Send(nullptr, Endpoint, -1.f, nullptr);
 		}
-		else if (_PollingMode == EPollingMode::IsServer && !IsClient) {
-			// EXECUTING ON SERVER, ATTEMPTING TO POLL CLIENTS
+		else if (_PollingMode == EPollingMode::IsServer) {
+			// POLL CLIENTS
 			for (auto i = _Pollers.CreateIterator(); i; ++i) {
 				if ((*i)->_PollingMode == EPollingMode::IsClient) {
-					(*i)->ClientPolled(Endpoint);
+					_Send(*i, Endpoint, -1.f, nullptr);
 				}
 			}
 		}
 	}
 }
 
+int32 UPollingClientComponent::Poll(const FString& Endpoint, FPollCallback Callback, float Timeout) {
+	if (_PollingMode == EPollingMode::IsServer) {
+		int32 Sent = 0;
+		// Copied, a callback resolving immediately may add or remove pollers.
+		auto Pollers = _Pollers;
+		for (auto Poller : Pollers) {
+			if (Poller->_PollingMode == EPollingMode::IsClient) {
+				Sent += _Send(Poller, Endpoint, Timeout, Callback) != 0 ? 1 : 0;
+			}
+		}
+		return Sent;
+	}
+	return _Send(nullptr, Endpoint, Timeout, MoveTemp(Callback)) != 0 ? 1 : 0;
+}
+
+TFuture<FPollResult> UPollingClientComponent::PollServer(const FString& Endpoint, float Timeout) {
+	TFuture<FPollResult> Future;
+	_Send(nullptr, Endpoint, Timeout, MakePollPromise(Future));
+	return Future;
+}
+
+TFuture<FPollResult> UPollingClientComponent::PollClient(UPollingClientComponent* Client, const FString& Endpoint, float Timeout) {
+	TFuture<FPollResult> Future;
+	auto Callback = MakePollPromise(Future);
+	if (!Client) {
+		FPollResult Result;
+		Result.Endpoint = Endpoint;
+		Callback(Result);
+		return Future;
+	}
+	_Send(Client, Endpoint, Timeout, MoveTemp(Callback));
+	return Future;
+}
+
+TArray<TFuture<FPollResult>> UPollingClientComponent::PollClients(const FString& Endpoint, float Timeout) {
+	TArray<TFuture<FPollResult>> Futures;
+	auto Pollers = _Pollers;
+	for (auto Poller : Pollers) {
+		if (Poller->_PollingMode == EPollingMode::IsClient) {
+			Futures.Add(PollClient(Poller, Endpoint, Timeout));
+		}
+	}
+	return Futures;
+}
+
+void UPollingClientComponent::CancelPoll(uint32 RequestId) {
+	_Resolve(RequestId, EPollStatus::Cancelled, FJsonObject(), nullptr);
+}
+
+void UPollingClientComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) {
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	double Now = FPlatformTime::Seconds();
+	TArray<uint32> TimedOut;
+	TArray<uint32> Cancelled;
+	for (auto& Pending : _Pending) {
+		if (!Pending.Value.Target.IsValid()) {
+			// The polled client left.
+			Cancelled.Add(Pending.Key);
+		} else if (Pending.Value.Deadline > 0.0 && Now >= Pending.Value.Deadline) {
+			TimedOut.Add(Pending.Key);
+		}
+	}
+	for (auto RequestId : Cancelled) {
+		_Resolve(RequestId, EPollStatus::Cancelled, FJsonObject(), nullptr);
+	}
+	for (auto RequestId : TimedOut) {
+		_Resolve(RequestId, EPollStatus::TimedOut, FJsonObject(), nullptr);
+	}
+
+	if (_Pending.Num() == 0) {
+		SetComponentTickEnabled(false);
+	}
+}
+
 void UPollingClientComponent::BeginDestroy() {
 	// Remove self from global pollers list.
 	_Pollers.Remove(this);
 	Super::BeginDestroy();
-}
\ No newline at end of file
+}
@@ -18,3 +18,15 @@ void URuleSet::InitRuleSet(const TMap<FName, TArray<FSpawnPoint>>& SpawnPoints)
 {
 	TeamSpawnPoints = SpawnPoints;
 }
+
+FName URuleSet::GetTeam(AController* Controller)
+{
+	for (auto Team = TeamSpawnPoints.CreateConstIterator(); Team; ++Team) {
+		for (auto& SpawnPoint : Team->Value) {
+			if (SpawnPoint.OccupyingPlayer && SpawnPoint.OccupyingPlayer == Controller) {
+				return Team->Key;
+			}
+		}
+	}
+	return NAME_None;
+}
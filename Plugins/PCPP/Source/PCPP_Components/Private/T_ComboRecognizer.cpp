@@ -0,0 +1,124 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "ComboRecognizer.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/*
+* Feeds scripted input events straight into a UComboRecognizer, no world or broadcaster involved.
+*
+* Usage: UE4Editor-Cmd <Project> -nullrhi -unattended -ExecCmds="Automation RunTests PCPP.Input.ComboRecognizer; Quit"
+*/
+
+namespace ComboRecognizerTest {
+	static const EInputBroadcastState Pressed = EInputBroadcastState::Pressed;
+	static const EInputBroadcastState Released = EInputBroadcastState::Released;
+
+	static FComboPattern MakePattern(FName Name, TArray<EDefaultInputLayout> Inputs, EInputBroadcastState State = Pressed) {
+		FComboPattern Pattern;
+		Pattern.Name = Name;
+		for (auto Input : Inputs) {
+			FComboStep Step;
+			Step.Input = Input;
+			Step.State = State;
+			Step.MaxDelay = 0.25f;
+			Pattern.Steps.Add(Step);
+		}
+		return Pattern;
+	}
+
+	// Recognizer with the given patterns, every match is appended to Matches.
+	static UComboRecognizer* MakeRecognizer(const TArray<FComboPattern>& Patterns, bool ResetOnMatch, TArray<FName>& Matches) {
+		auto Recognizer = NewObject<UComboRecognizer>();
+		Recognizer->Patterns = Patterns;
+		Recognizer->ResetOnMatch = ResetOnMatch;
+		Recognizer->Compile();
+		Recognizer->OnComboMatchedNative.AddLambda([Recognizer, &Matches](int32 PatternIndex) {
+			Matches.Add(Recognizer->Patterns[PatternIndex].Name);
+		});
+		return Recognizer;
+	}
+
+	static void Feed(UComboRecognizer* Recognizer, EDefaultInputLayout Input, EInputBroadcastState State, float Time) {
+		Recognizer->Feed((uint8)Input, State, Time);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FComboRecognizerTest, "PCPP.Input.ComboRecognizer", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FComboRecognizerTest::RunTest(const FString& Parameters) {
+	using namespace ComboRecognizerTest;
+	const FName QuarterCircle = TEXT("QuarterCircle");
+	const FName Dash = TEXT("Dash");
+	const FName DoubleDown = TEXT("DoubleDown");
+	const FName Tap = TEXT("Tap");
+
+	// Releases of pressed-only inputs in between the steps.
+	{
+		TArray<FName> Matches;
+		auto Recognizer = MakeRecognizer({ MakePattern(QuarterCircle, { EDefaultInputLayout::Down, EDefaultInputLayout::Right, EDefaultInputLayout::Confirm }) }, true, Matches);
+		Feed(Recognizer, EDefaultInputLayout::Down, Pressed, 0.00f);
+		Feed(Recognizer, EDefaultInputLayout::Right, Pressed, 0.05f);
+		Feed(Recognizer, EDefaultInputLayout::Down, Released, 0.08f);
+		Feed(Recognizer, EDefaultInputLayout::Right, Released, 0.10f);
+		Feed(Recognizer, EDefaultInputLayout::Confirm, Pressed, 0.15f);
+		TestEqual(TEXT("Releases between presses don't break the combo"), Matches.Num(), 1);
+	}
+
+	// A step outside its window drops the combo, a fresh attempt still matches.
+	{
+		TArray<FName> Matches;
+		auto Recognizer = MakeRecognizer({ MakePattern(QuarterCircle, { EDefaultInputLayout::Down, EDefaultInputLayout::Right, EDefaultInputLayout::Confirm }) }, true, Matches);
+		Feed(Recognizer, EDefaultInputLayout::Down, Pressed, 0.0f);
+		Feed(Recognizer, EDefaultInputLayout::Right, Pressed, 0.5f);
+		Feed(Recognizer, EDefaultInputLayout::Confirm, Pressed, 0.6f);
+		TestEqual(TEXT("Late step doesn't match"), Matches.Num(), 0);
+
+		Feed(Recognizer, EDefaultInputLayout::Down, Pressed, 1.0f);
+		Feed(Recognizer, EDefaultInputLayout::Right, Pressed, 1.1f);
+		Feed(Recognizer, EDefaultInputLayout::Confirm, Pressed, 1.2f);
+		TestEqual(TEXT("Retry after a timeout matches"), Matches.Num(), 1);
+	}
+
+	// A pattern that is a suffix of another matches along with it.
+	{
+		TArray<FName> Matches;
+		auto Recognizer = MakeRecognizer({
+			MakePattern(QuarterCircle, { EDefaultInputLayout::Down, EDefaultInputLayout::Right, EDefaultInputLayout::Confirm }),
+			MakePattern(Dash, { EDefaultInputLayout::Right, EDefaultInputLayout::Confirm })
+		}, true, Matches);
+		Feed(Recognizer, EDefaultInputLayout::Down, Pressed, 0.0f);
+		Feed(Recognizer, EDefaultInputLayout::Right, Pressed, 0.1f);
+		Feed(Recognizer, EDefaultInputLayout::Confirm, Pressed, 0.2f);
+		TestTrue(TEXT("Longer combo matches"), Matches.Contains(QuarterCircle));
+		TestTrue(TEXT("Suffix combo matches"), Matches.Contains(Dash));
+	}
+
+	// Overlapping matches without ResetOnMatch.
+	{
+		TArray<FName> Matches;
+		auto Recognizer = MakeRecognizer({ MakePattern(DoubleDown, { EDefaultInputLayout::Down, EDefaultInputLayout::Down }) }, false, Matches);
+		Feed(Recognizer, EDefaultInputLayout::Down, Pressed, 0.0f);
+		Feed(Recognizer, EDefaultInputLayout::Down, Released, 0.05f);
+		Feed(Recognizer, EDefaultInputLayout::Down, Pressed, 0.1f);
+		Feed(Recognizer, EDefaultInputLayout::Down, Pressed, 0.2f);
+		TestEqual(TEXT("Overlapping matches are all reported"), Matches.Num(), 2);
+	}
+
+	// Releases a pattern does use still count.
+	{
+		TArray<FName> Matches;
+		FComboPattern Pattern = MakePattern(Tap, { EDefaultInputLayout::Confirm, EDefaultInputLayout::Confirm });
+		Pattern.Steps[1].State = Released;
+		auto Recognizer = MakeRecognizer({ Pattern }, true, Matches);
+		Feed(Recognizer, EDefaultInputLayout::Confirm, Pressed, 0.0f);
+		Feed(Recognizer, EDefaultInputLayout::Confirm, Released, 0.1f);
+		TestEqual(TEXT("Used release completes the combo"), Matches.Num(), 1);
+	}
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,164 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Engine/World.h"
+#include "Engine/Engine.h"
+#include "Components/SphereComponent.h"
+#include "LockOnSystem.h"
+#include "PCPP_UE4.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/*
+* Stress benchmark for ULockOnSystem.
+* Spawns N lockable dummies into a throwaway world and drives BeginLockOn / CycleLock / EndLockOn with a scripted input sequence.
+* Timings (p50/p99) and memory growth (FPlatformMemory::GetStats) are written as JSON to the automation directory.
+*
+* Usage: UE4Editor-Cmd <Project> -nullrhi -unattended -ExecCmds="Automation RunTests PCPP.LockOn.Benchmark; Quit"
+*/
+
+namespace LockOnBenchmark {
+	// How many times the scripted input sequence is replayed per dummy count.
+	static const int32 Iterations = 200;
+
+	// Timings (in ms) and memory growth for a single operation type.
+	struct FSamples {
+		TArray<double> Times;
+		int64 MemoryBytes = 0;
+
+		double Percentile(float P) {
+			if (Times.Num() == 0) {
+				return 0.0;
+			}
+			Times.Sort();
+			int32 Index = FMath::Clamp(FMath::CeilToInt(P * Times.Num()) - 1, 0, Times.Num() - 1);
+			return Times[Index];
+		}
+
+		TSharedPtr<FJsonObject> ToJson() {
+			TSharedPtr<FJsonObject> Out = MakeShareable(new FJsonObject());
+			Out->SetNumberField("Samples", Times.Num());
+			Out->SetNumberField("P50Ms", Percentile(0.5f));
+			Out->SetNumberField("P99Ms", Percentile(0.99f));
+			Out->SetNumberField("MemoryBytes", (double)MemoryBytes);
+			Out->SetNumberField("MemoryBytesPerCall", Times.Num() > 0 ? (double)MemoryBytes / Times.Num() : 0.0);
+			return Out;
+		}
+	};
+
+	// Runs a single operation while sampling time and memory growth.
+	// Memory stats are process wide and may be slow to query, so they are read outside of the timed section.
+	template<typename F>
+	static void Measure(FSamples& Samples, F Operation) {
+		int64 MemoryBefore = (int64)FPlatformMemory::GetStats().UsedPhysical;
+		double Start = FPlatformTime::Seconds();
+		Operation();
+		double End = FPlatformTime::Seconds();
+		Samples.MemoryBytes += (int64)FPlatformMemory::GetStats().UsedPhysical - MemoryBefore;
+		Samples.Times.Add((End - Start) * 1000.0);
+	}
+
+	// Creates an actor with a blocking sphere and a (lockable) ULockOnSystem at the given location.
+	static ULockOnSystem* SpawnLockable(UWorld* World, const FVector& Location) {
+		AActor* Actor = World->SpawnActor<AActor>();
+		if (!Actor) {
+			return nullptr;
+		}
+
+		auto Sphere = NewObject<USphereComponent>(Actor);
+		Sphere->InitSphereRadius(50.f);
+		Sphere->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+		Sphere->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Block);
+		Actor->SetRootComponent(Sphere);
+		Sphere->RegisterComponent();
+		Actor->SetActorLocation(Location);
+
+		auto LockOnSystem = NewObject<ULockOnSystem>(Actor);
+		LockOnSystem->RegisterComponent();
+		return LockOnSystem;
+	}
+}
+
+IMPLEMENT_COMPLEX_AUTOMATION_TEST(FLockOnBenchmark, "PCPP.LockOn.Benchmark", EAutomationTestFlags::EngineFilter | EAutomationTestFlags::ClientContext | EAutomationTestFlags::PerfFilter)
+
+void FLockOnBenchmark::GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const {
+	const TArray<int32> Counts = { 100, 1000, 10000 };
+	for (auto It = Counts.CreateConstIterator(); It; ++It) {
+		OutBeautifiedNames.Add(FString::Printf(TEXT("%d Dummies"), *It));
+		OutTestCommands.Add(FString::FromInt(*It));
+	}
+}
+
+bool FLockOnBenchmark::RunTest(const FString& Parameters) {
+	using namespace LockOnBenchmark;
+	int32 DummyCount = FCString::Atoi(*Parameters);
+
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, FName(*FString::Printf(TEXT("LockOnBenchmark_%d"), DummyCount)));
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+	World->InitializeActorsForPlay(FURL());
+	World->BeginPlay();
+
+	// The source of the lock faces +X from the origin.
+	auto Source = SpawnLockable(World, FVector::ZeroVector);
+
+	// Distribute dummies through the default sweep corridor (Near 300, Far 1000, Radius 250) plus a margin so some fall outside.
+	FRandomStream Stream(DummyCount);
+	for (int32 i = 0; i < DummyCount; ++i) {
+		FVector Location(
+			Stream.FRandRange(200.f, 1200.f),
+			Stream.FRandRange(-400.f, 400.f),
+			Stream.FRandRange(-400.f, 400.f)
+		);
+		SpawnLockable(World, Location);
+	}
+
+	// Let the physics scene pick up the new bodies.
+	World->Tick(ELevelTick::LEVELTICK_All, 1.f / 60.f);
+
+	FSamples BeginSamples;
+	FSamples CycleSamples;
+	FSamples EndSamples;
+	int32 FailedLocks = 0;
+
+	// Scripted input: lock, flick right three times, flick left once, release.
+	for (int32 i = 0; i < Iterations; ++i) {
+		bool Locked = false;
+		Measure(BeginSamples, [&]() { Locked = Source->BeginLockOn(); });
+		if (!Locked) {
+			FailedLocks++;
+			continue;
+		}
+		Measure(CycleSamples, [&]() { Source->CycleLock(+1); });
+		Measure(CycleSamples, [&]() { Source->CycleLock(+1); });
+		Measure(CycleSamples, [&]() { Source->CycleLock(+1); });
+		Measure(CycleSamples, [&]() { Source->CycleLock(-1); });
+		Measure(EndSamples, [&]() { Source->EndLockOn(); });
+	}
+
+	// Build the artifact.
+	FJsonObject Report;
+	Report.SetNumberField("DummyCount", DummyCount);
+	Report.SetNumberField("Iterations", Iterations);
+	Report.SetNumberField("FailedLocks", FailedLocks);
+	Report.SetObjectField("BeginLockOn", BeginSamples.ToJson());
+	Report.SetObjectField("CycleLock", CycleSamples.ToJson());
+	Report.SetObjectField("EndLockOn", EndSamples.ToJson());
+
+	FString OutputPath = FPaths::Combine(FPaths::AutomationDir(), FString::Printf(TEXT("LockOnBenchmark_%d.json"), DummyCount));
+	FFileHelper::SaveStringToFile(PCPP_UE4::JSON::ToString(Report), *OutputPath);
+	AddInfo(FString::Printf(TEXT("LockOn benchmark written to %s"), *OutputPath));
+
+	// Tear down the throwaway world.
+	GEngine->DestroyWorldContext(World);
+	World->CleanupWorld();
+	World->DestroyWorld(false);
+
+	TestEqual(TEXT("Every scripted lock attempt found a target"), FailedLocks, 0);
+	return true;
+}
+
+#endif
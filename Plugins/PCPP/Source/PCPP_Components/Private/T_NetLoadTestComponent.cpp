@@ -0,0 +1,173 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "T_NetLoadTestComponent.h"
+#include "NetReplicate.h"
+#include "RPGCore.h"
+#include "PollingClientComponent.h"
+#include "GameFramework/Pawn.h"
+#include "PCPP_UE4.h"
+
+int64 UT_NetLoadTestComponent::PollsSent = 0;
+int64 UT_NetLoadTestComponent::PollsAnswered = 0;
+int64 UT_NetLoadTestComponent::PollsTimedOut = 0;
+int64 UT_NetLoadTestComponent::HitsReceived = 0;
+
+static const FName LoadTestEndpoint = TEXT("LOADTEST");
+
+UT_NetLoadTestComponent::UT_NetLoadTestComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	Radius = 600.f;
+	AngularSpeed = 1.f;
+	ReplicationFrequency = 0.05f;
+	PollInterval = 1.f;
+	PollsPerInterval = 4;
+	Predict = true;
+	PredictionTolerance = 10.f;
+
+	NetReplicate = nullptr;
+	RPGCore = nullptr;
+	Poller = nullptr;
+	Origin = FVector::ZeroVector;
+	Angle = 0.f;
+	PollTimer = 0.f;
+	StepSeconds = 0.f;
+}
+
+void UT_NetLoadTestComponent::BeginPlay()
+{
+	Super::BeginPlay();
+	Origin = GetOwner()->GetActorLocation();
+	// Spread the pawns around their circles so that updates differ.
+	Angle = FMath::FRandRange(0.f, 2.f * PI);
+	PollTimer = FMath::FRandRange(0.f, PollInterval);
+
+	if (PCPP_UE4::LazyGetComp(GetOwner(), RPGCore)) {
+		FRPGStatConfig Bound;
+		Bound.LiteralDefault = 0.f;
+		RPGCore->BindStat(TEXT("MinHP"), Bound);
+		RPGCore->BindStat(TEXT("MinStamina"), Bound);
+		Bound.LiteralDefault = 100.f;
+		RPGCore->BindStat(TEXT("MaxHP"), Bound);
+		RPGCore->BindStat(TEXT("MaxStamina"), Bound);
+
+		FRPGStatConfig Constrained;
+		Constrained.MinimumConstraint = TEXT("MinHP");
+		Constrained.MaximumConstraint = TEXT("MaxHP");
+		RPGCore->BindStat(TEXT("HP"), Constrained, EStatDefault::Maximum);
+		Constrained.MinimumConstraint = TEXT("MinStamina");
+		Constrained.MaximumConstraint = TEXT("MaxStamina");
+		RPGCore->BindStat(TEXT("Stamina"), Constrained, EStatDefault::Maximum);
+	}
+
+	// Every party registers.
+	if (PCPP_UE4::LazyGetComp(GetOwner(), NetReplicate)) {
+		NetReplicate->RegisterReplication(ReplicationFrequency, this);
+		HitChannel.Bind(NetReplicate, TEXT("LoadTestHit"), false, [](const FVector& Location, const float& Damage) {
+			HitsReceived++;
+		});
+	}
+}
+
+void UT_NetLoadTestComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	auto Pawn = Cast<APawn>(GetOwner());
+	PCPP_UE4::Network::Local(Pawn, [&]() {
+		_Simulate(DeltaTime, false);
+		if (Predict) {
+			StepSeconds = DeltaTime;
+			RecordPrediction();
+		}
+
+		// Poll.
+		if (PollInterval > 0.f && PCPP_UE4::LazyGetComp(GetOwner(), Poller)) {
+			PollTimer -= DeltaTime;
+			if (PollTimer <= 0.f) {
+				PollTimer += PollInterval;
+				for (int32 i = 0; i < PollsPerInterval; ++i) {
+					PollsSent += Poller->Poll(LoadTestEndpoint.ToString(), [](const FPollResult& Result) {
+						PollsAnswered += Result.Status == EPollStatus::Answered ? 1 : 0;
+						PollsTimedOut += Result.Status == EPollStatus::TimedOut ? 1 : 0;
+					});
+				}
+			}
+		}
+	});
+}
+
+void UT_NetLoadTestComponent::_Simulate(float DeltaTime, bool Replaying) {
+	// Walk.
+	Angle = FMath::Fmod(Angle + AngularSpeed * DeltaTime, 2.f * PI);
+	FVector Location = Origin + FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.f) * Radius;
+	GetOwner()->SetActorLocationAndRotation(Location, FRotator(0.f, FMath::RadiansToDegrees(Angle) + 90.f, 0.f));
+
+	// Spend stamina while walking, take a hit every lap and regenerate.
+	if (RPGCore) {
+		RPGCore->AddStat(TEXT("Stamina"), (RPGCore->GetStat(TEXT("Stamina")) > 10.f ? -5.f : 50.f) * DeltaTime);
+		if (Angle < AngularSpeed * DeltaTime) {
+			RPGCore->AddStat(TEXT("HP"), -25.f);
+			if (!Replaying) {
+				ForceUpdate();
+				HitChannel.Send(GetOwner()->GetActorLocation(), 25.f);
+			}
+		}
+		RPGCore->AddStat(TEXT("HP"), 2.f * DeltaTime);
+	}
+}
+
+void UT_NetLoadTestComponent::_SerializeState(FArchive& Ar, FVector& Location, FRotator& Rotation, float& HP, float& Stamina) {
+	PCPP_UE4::Quantize::Vector(Ar, Location);
+	PCPP_UE4::Quantize::Rotator(Ar, Rotation);
+	PCPP_UE4::Quantize::Float(Ar, HP, 0.f, 100.f, 8);
+	PCPP_UE4::Quantize::Float(Ar, Stamina, 0.f, 100.f, 8);
+}
+
+void UT_NetLoadTestComponent::SerializeReplication(FArchive& Ar) {
+	FVector Location = GetOwner()->GetActorLocation();
+	FRotator Rotation = GetOwner()->GetActorRotation();
+	float HP = RPGCore ? RPGCore->GetStat(TEXT("HP")) : 0.f;
+	float Stamina = RPGCore ? RPGCore->GetStat(TEXT("Stamina")) : 0.f;
+
+	_SerializeState(Ar, Location, Rotation, HP, Stamina);
+
+	if (Ar.IsLoading() && !Ar.IsError()) {
+		GetOwner()->SetActorLocationAndRotation(Location, Rotation);
+		// Continue walking from here. (Rewinds)
+		Angle = FMath::Atan2(Location.Y - Origin.Y, Location.X - Origin.X);
+		Angle = Angle < 0.f ? Angle + 2.f * PI : Angle;
+		if (RPGCore) {
+			RPGCore->SetStat(TEXT("HP"), HP);
+			RPGCore->SetStat(TEXT("Stamina"), Stamina);
+		}
+	}
+}
+
+void UT_NetLoadTestComponent::SerializePredictionMove(FArchive& Ar) {
+	Ar << StepSeconds;
+}
+
+void UT_NetLoadTestComponent::ReplayPrediction(FArchive& Move) {
+	float Seconds = 0.f;
+	Move << Seconds;
+	_Simulate(Seconds, true);
+}
+
+float UT_NetLoadTestComponent::GetPredictionError(FArchive& Predicted, FArchive& Authoritative) {
+	FVector Locations[2];
+	FRotator Rotation;
+	float HP = 0.f;
+	float Stamina = 0.f;
+	_SerializeState(Predicted, Locations[0], Rotation, HP, Stamina);
+	_SerializeState(Authoritative, Locations[1], Rotation, HP, Stamina);
+	return FVector::Dist(Locations[0], Locations[1]);
+}
+
+FJsonObject UT_NetLoadTestComponent::MakeResponseObject(const FString& Endpoint) {
+	FJsonObject Out;
+	if (Endpoint == LoadTestEndpoint.ToString()) {
+		Out.SetNumberField("Time", GetWorld()->GetTimeSeconds());
+	}
+	return Out;
+}
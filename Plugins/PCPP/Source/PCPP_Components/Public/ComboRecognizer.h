@@ -0,0 +1,132 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "InputBroadcaster.h"
+#include "ComboRecognizer.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FComboMatchedDelegate, FName, Combo);
+
+// Native version of FComboMatchedDelegate. (Index into Patterns)
+DECLARE_MULTICAST_DELEGATE_OneParam(FNativeComboMatchedDelegate, int32);
+
+USTRUCT(BlueprintType)
+struct FComboStep {
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere)
+	EDefaultInputLayout Input;
+
+	// Held is not supported, it is broadcast every frame.
+	UPROPERTY(EditAnywhere)
+	EInputBroadcastState State;
+
+	// Maximum time (seconds) since the previous step. Ignored for the first step.
+	UPROPERTY(EditAnywhere)
+	float MaxDelay;
+
+	FComboStep() : Input(EDefaultInputLayout::Confirm), State(EInputBroadcastState::Pressed), MaxDelay(0.25f) {}
+};
+
+USTRUCT(BlueprintType)
+struct FComboPattern {
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere)
+	FName Name;
+
+	UPROPERTY(EditAnywhere)
+	TArray<FComboStep> Steps;
+};
+
+/*
+* Recognizes command inputs (ie: Down, Right, Confirm) from the owner's UInputBroadcaster.
+*
+* Patterns are compiled into a DFA (Aho-Corasick automaton over Input x State) so that every event is a single table lookup regardless of the amount of patterns.
+* Events (Input x State) that no pattern uses are ignored instead of breaking a combo, ie: releases in a combo of presses. A state is dropped once the time since the last event exceeds every window leaving it,
+* and the exact per-step windows of a pattern are verified against the recent event times only when it matches.
+* Nothing is allocated after Compile.
+*/
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class PCPP_COMPONENTS_API UComboRecognizer : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	// Longest supported pattern.
+	static const int32 MaxSteps = 32;
+
+	UComboRecognizer();
+
+	// Call Compile after changing at runtime.
+	UPROPERTY(EditAnywhere)
+	TArray<FComboPattern> Patterns;
+
+	// Start over after a match so that the same input doesn't complete a second combo.
+	UPROPERTY(EditAnywhere)
+	bool ResetOnMatch;
+
+	UPROPERTY(BlueprintAssignable)
+	FComboMatchedDelegate OnComboMatched;
+
+	FNativeComboMatchedDelegate OnComboMatchedNative;
+
+	// Builds the automaton from Patterns.
+	UFUNCTION(BlueprintCallable)
+	void Compile();
+
+	// Advances the automaton by one input. Called automatically for the owner's UInputBroadcaster.
+	void Feed(uint8 Input, EInputBroadcastState State, float Time);
+
+	// Returns to the start state.
+	UFUNCTION(BlueprintCallable)
+	void Reset();
+
+protected:
+	// Pressed / Released per input.
+	static const int32 StatesPerInput = 2;
+
+	int32 NumSymbols;
+
+	// Dense transition table, NumSymbols per node. Node 0 is the start state.
+	TArray<int32> Transitions;
+
+	// Longest window of any transition leaving the node.
+	TArray<float> NodeMaxDelay;
+
+	// Patterns matched at a node, OutputCount entries starting at OutputStart into Outputs.
+	TArray<int32> OutputStart;
+	TArray<int32> OutputCount;
+	TArray<int32> Outputs;
+
+	// Whether a symbol is used by any pattern.
+	TArray<bool> UsedSymbols;
+
+	int32 Current;
+
+	// Times of the most recent accepted events.
+	float History[MaxSteps];
+	int32 HistoryHead;
+	int32 HistoryCount;
+
+	UInputBroadcaster* Broadcaster;
+	FDelegateHandle BroadcasterHandle;
+
+	FORCEINLINE int32 Symbol(uint8 Input, EInputBroadcastState State) const { return Input * StatesPerInput + (State == EInputBroadcastState::Released ? 1 : 0); };
+
+	// Time of the event Back events ago (0 = latest).
+	FORCEINLINE float HistoryAt(int32 Back) const { return History[(HistoryHead - 1 - Back + MaxSteps) % MaxSteps]; };
+
+	// Verifies the windows of a pattern against the event history.
+	bool MatchesTiming(const FComboPattern& Pattern) const;
+
+	int32 AddNode();
+
+	void OnBroadcasterInput(uint8 Input, EInputBroadcastState State, float Magnitude);
+
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+};
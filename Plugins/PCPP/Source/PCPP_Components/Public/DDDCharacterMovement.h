@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/CharacterMovementComponent.h"
+#include "InputLatency.h"
 #include "DDDCharacterMovement.generated.h"
 
 UENUM(BlueprintType)
@@ -14,6 +15,21 @@ enum class EDDDMovementMode : uint8 {
 	DDD_Dead	UMETA(DisplayName = "Dead"),
 };
 
+/*
+* Bits for the properties published by UDDDCharacterMovement. Used with GetDirtySince.
+*/
+namespace EDDDDirty {
+	enum Type : uint8 {
+		Mode		= 1 << 0,
+		Speed		= 1 << 1,
+		Aim			= 1 << 2,
+		IdleTime	= 1 << 3,
+		Turn		= 1 << 4,
+		Count		= 5,
+		All			= 0xFF
+	};
+}
+
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FMoveModeChangeDelegate);
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FMoveInterruptedDelegate);
@@ -41,6 +57,14 @@ struct FDDDCharacterMovementConfig {
 	// How quickly to track a target for aiming. Lower values will make the movement smoother but slower.
 	UPROPERTY(EditAnywhere)
 	float AimSpeed;
+
+	// If set then aim / turn / idle bookkeeping is handed to UDDDMovementBatcher instead of running in this component's tick.
+	UPROPERTY(EditAnywhere)
+	bool UseBatchedUpdate;
+
+	// How long (seconds) the owner has to hold a steady state before bookkeeping goes to sleep. <= 0 disables sleeping.
+	UPROPERTY(EditAnywhere)
+	float SleepThreshold;
 };
 
 /**
@@ -51,12 +75,21 @@ class PCPP_COMPONENTS_API UDDDCharacterMovement : public UCharacterMovementCompo
 {
 	GENERATED_BODY()
 
+	// Batcher reads / writes the bookkeeping state directly.
+	friend class UDDDMovementBatcher;
+
 protected:
 	UPROPERTY(BlueprintReadOnly)
 	EDDDMovementMode DDDMovementMode;
 
 	virtual void OnComponentCreated() override;
 
+	// Registers with UDDDMovementBatcher if batching is enabled.
+	virtual void BeginPlay() override;
+
+	// Unregisters from UDDDMovementBatcher if needed.
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	UFUNCTION()
 	void __OnWalk();
 
@@ -75,6 +108,57 @@ protected:
 	void __TrackTarget(float DeltaTime);
 	void __TrackTurn();
 
+	// Updates the sleep state for this frame, returns true if bookkeeping should be skipped.
+	bool __UpdateSleep(float DeltaTime);
+	void __Sleep();
+	void __Wake();
+
+	// Whether the bookkeeping is currently asleep.
+	UPROPERTY(BlueprintReadOnly)
+	bool Sleeping;
+
+	// How long the owner has been in a steady state while awake.
+	float SteadyTime;
+
+	// Whether movement input was pending this frame, sampled before the base tick consumes it.
+	bool HasPendingInput;
+
+	// World time at which the owner became idle. IdleTime is derived from this while asleep.
+	float IdleStartTime;
+
+	// Control rotation at the time of sleeping, used to detect wake ups when aiming with control rotation.
+	FRotator SleepControlRotation;
+
+	// Whether bookkeeping is currently handled by UDDDMovementBatcher.
+	bool Batched;
+
+	// Last values published to consumers and the change stamp each one last changed with.
+	float PublishedSpeed;
+	float PublishedAimPitch;
+	float PublishedAimYaw;
+	float PublishedIdleTime;
+	float PublishedTurn;
+	uint64 ChangedStamp[EDDDDirty::Count];
+
+	// Incremented for every change. The batcher publishes after anim updates of the same frame, so GFrameCounter can't order changes.
+	static uint64 ChangeCounter;
+
+	void __MarkDirty(uint8 Mask);
+
+	// Compares the current values against those last published and marks any that changed. Called once per frame.
+	void __Publish();
+
+	// Input currently being followed for latency, ended by the next movement tick.
+	FInputLatencyTrace LatencyTrace;
+
+	// Whether a mode carried by a client move may be applied. Entering and leaving Dead is left to the server.
+	bool CanApplyNetworkedMode(EDDDMovementMode NewMovementMode);
+
+	friend class FSavedMove_DDD;
+
+	// Applies the DDD Movement Mode carried in the client's saved move flags.
+	virtual void UpdateFromCompressedFlags(uint8 Flags) override;
+
 	float FinalAimPitch;
 	float FinalAimYaw;
 	float CurrentAimPitch;
@@ -92,6 +176,9 @@ public:
 
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 
+	// Allocates FNetworkPredictionData_Client_DDD so that saved moves carry the DDD Movement Mode.
+	virtual FNetworkPredictionData_Client* GetPredictionData_Client() const override;
+
 	// Sets whether or not to use the actor's control rotation for setting Aim Pitch / Aim Yaw instead of a TargetLocation.
 	UPROPERTY(BlueprintReadWrite)
 	bool UseControlRotationForAiming;
@@ -128,9 +215,13 @@ public:
 	UFUNCTION(BlueprintCallable)
 	void SetDDDMovementMode(EDDDMovementMode NewMovementMode);
 
-	// Sets the location to be targeted for Aim Pitch / Aim Yaw.
+	// Sets the location to be targeted for Aim Pitch / Aim Yaw. Wakes the bookkeeping if the target changes.
 	void SetTargetLocation(FVector NewTargetLocation);
 
+	// Whether aim / turn / idle bookkeeping is asleep due to the owner holding a steady state.
+	UFUNCTION(BlueprintPure)
+	bool IsSleeping() { return Sleeping; };
+
 	// Where the owner is aiming.
 	UFUNCTION(BlueprintPure)
 	float GetAimYaw();
@@ -150,6 +241,53 @@ public:
 	UFUNCTION(BlueprintPure)
 	float GetIdleTime();
 
+	/*
+	* Bitmask (EDDDDirty) of the published properties that changed after the given stamp (GetChangeStamp).
+	* Consumers keep the stamp of their last copy and only copy the properties whose bit is set.
+	*/
+	uint8 GetDirtySince(uint64 Stamp) const;
+
+	// Stamp of the latest change of any movement component, never decreases.
+	static uint64 GetChangeStamp() { return ChangeCounter; }
+
+	// Starts following an input (EDDDDriverInput) until the movement tick that applies it. No-op unless pcpp.Input.TraceLatency is set.
+	void TraceInput(uint8 Input);
+
+	// Samples a stage of the input being followed, if any.
+	void MarkInputTrace(EInputLatencyStage Stage);
+
 	FORCEINLINE UFUNCTION(BlueprintPure)
 	EDDDMovementMode GetDDDMovementMode() { return DDDMovementMode; };
 };
+
+/*
+* Saved move that carries the DDD Movement Mode so that sprint / crouch are predicted.
+* The mode is packed into FLAG_Custom_0 and FLAG_Custom_1 of the compressed flags.
+*/
+class PCPP_COMPONENTS_API FSavedMove_DDD : public FSavedMove_Character
+{
+public:
+	typedef FSavedMove_Character Super;
+
+	EDDDMovementMode SavedDDDMovementMode;
+
+	virtual void Clear() override;
+	virtual uint8 GetCompressedFlags() const override;
+	virtual bool CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const override;
+	virtual void SetMoveFor(ACharacter* InCharacter, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData) override;
+	virtual void PrepMoveFor(ACharacter* InCharacter) override;
+
+	static uint8 EncodeMode(EDDDMovementMode Mode);
+	static EDDDMovementMode DecodeMode(uint8 Flags);
+};
+
+// Client prediction data which allocates FSavedMove_DDD.
+class PCPP_COMPONENTS_API FNetworkPredictionData_Client_DDD : public FNetworkPredictionData_Client_Character
+{
+public:
+	typedef FNetworkPredictionData_Client_Character Super;
+
+	FNetworkPredictionData_Client_DDD(const UCharacterMovementComponent& ClientMovement);
+
+	virtual FSavedMovePtr AllocateNewMove() override;
+};
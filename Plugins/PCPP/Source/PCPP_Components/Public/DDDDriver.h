@@ -7,9 +7,24 @@
 #include "DDDCharacterMovement.h"
 #include "Components/InputComponent.h"
 #include "LockOnSystem.h"
+#include "InputBuffer.h"
+#include "DodgeSystem.h"
+#include "InputRecorder.h"
 #include "GameFramework/Character.h"
 #include "DDDDriver.generated.h"
 
+// Input ids used by the driver when recording into a UInputBuffer / UInputRecorder.
+UENUM(BlueprintType)
+enum class EDDDDriverInput : uint8 {
+	MoveForward,
+	MoveRight,
+	Sprint,
+	Crouch,
+	Dodge,
+	TurnUp,
+	TurnRight,
+	MAX
+};
 
 UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
 class PCPP_COMPONENTS_API UDDDDriver : public UActorComponent
@@ -51,9 +66,70 @@ protected:
 	UCameraComponent* OwnerCamera;
 	UCameraComponent* GetOwnerCamera();
 
+	// If an input buffer (optional) exists, input is recorded into it and handled once per frame in TickComponent.
+	UInputBuffer* InputBuffer;
+	UInputBuffer* GetInputBuffer();
+
+	// Dodge system (optional) used by the Dodge input.
+	UDodgeSystem* DodgeSystem;
+	UDodgeSystem* GetDodgeSystem();
+
+	// If an input recorder (optional) exists, every bound input goes through it. Live input is ignored while it replays.
+	UInputRecorder* InputRecorder;
+	UInputRecorder* GetInputRecorder();
+
+	// How long (seconds) a buffered sprint / dodge press stays valid while it can't be performed.
+	UPROPERTY(EditAnywhere)
+	float ActionBufferWindow;
+
 	// Called when the game starts
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Moves the tick prerequisite to the new controller so input is always drained after it.
+	UFUNCTION()
+	void OnControllerChanged(APawn* Pawn, AController* OldController, AController* NewController);
+
+	// Drains the input buffer (if used) and applies the combined movement.
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	// Applies forward / right movement using a single camera basis computation.
+	void ApplyMovement(float ForwardValue, float RightValue);
+
+	bool CanSprint();
+	bool CanDodge();
+
+	// Bound input entry points, forwarded to __OnInput.
+	UFUNCTION()
+	void __InputMoveForward(float AxisValue);
+	UFUNCTION()
+	void __InputMoveRight(float AxisValue);
+	UFUNCTION()
+	void __InputSprintPressed();
+	UFUNCTION()
+	void __InputSprintReleased();
+	UFUNCTION()
+	void __InputCrouch();
+	UFUNCTION()
+	void __InputDodge();
+	UFUNCTION()
+	void __InputTurnUp(float AxisValue);
+	UFUNCTION()
+	void __InputTurnRight(float AxisValue);
+
+	// Live input. Recorded / dropped depending on the input recorder, then handled.
+	void __OnInput(EDDDDriverInput Input, float Value);
+
+	// Records into the input buffer if one exists, otherwise performs the input immediately.
+	void __HandleInput(EDDDDriverInput Input, float Value);
+
+	// Last MoveForward / MoveRight values seen while tracing latency, movement starting is traced like a press.
+	float TracedMoveAxes[2];
+
+	// Starts a latency trace for presses and movement starting.
+	void __TraceInput(EDDDDriverInput Input, float Value);
+
 	// Pre-Implemented Forward Movement for Owner.
 	UFUNCTION()
 	void MoveForward(float AxisValue);
@@ -82,8 +158,15 @@ protected:
 	UFUNCTION()
 	void TurnUp(float AxisValue);
 
+	// Pre-Implemented Dodge for Owner. Requires a UDodgeSystem.
+	UFUNCTION()
+	void Dodge();
+
 public:	
 
+	// Feeds a (replayed) input as if it came from the bound input component. Input is an EDDDDriverInput.
+	void InjectInput(uint8 Input, float Value);
+
 	// Take Axis / Input Keys and automatically map the InputComponent accordingly. Any set to NAME_None will be ignored.
 	void BindInputs(
 		UInputComponent* InputComponent,
@@ -92,6 +175,7 @@ public:
 		FName Sprint = NAME_None,
 		FName Crouch = NAME_None,
 		FName UpTurnAxis = NAME_None,
-		FName RightTurnAxis = NAME_None
+		FName RightTurnAxis = NAME_None,
+		FName DodgeAction = NAME_None
 	);
 };
@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "DDDMovementBatcher.generated.h"
+
+class UDDDCharacterMovement;
+
+/*
+* Structure of Arrays holding the per character bookkeeping inputs / outputs.
+* Arrays are padded to a multiple of 4 so that the math can run in 4 wide vector packets.
+*/
+struct FDDDMovementBatch {
+	// Inputs (Gathered)
+	TArray<float> LocationX;
+	TArray<float> LocationY;
+	TArray<float> LocationZ;
+	TArray<float> TargetX;
+	TArray<float> TargetY;
+	TArray<float> TargetZ;
+	TArray<float> ActorPitch;
+	TArray<float> ActorYaw;
+	TArray<float> ControlPitch;
+	TArray<float> ControlYaw;
+	TArray<float> Speed;
+	TArray<float> AimSpeed;
+	TArray<float> PreviousYaw;
+	TArray<uint8> UseControlRotation;
+	TArray<uint8> HasPawn;
+
+	// Inputs / Outputs (Gathered then Scattered)
+	TArray<float> CurrentAimPitch;
+	TArray<float> CurrentAimYaw;
+	TArray<float> FinalAimPitch;
+	TArray<float> FinalAimYaw;
+	TArray<float> Turn;
+	TArray<float> IdleTime;
+
+	// Resizes every array, padding to a multiple of the packet width. Memory is retained between frames.
+	void SetNum(int32 Num);
+};
+
+/*
+* Opt-in manager that runs the aim / turn / idle bookkeeping of every registered UDDDCharacterMovement in a single tick.
+* Per character inputs are gathered into SoA arrays, processed with one ParallelFor, then scattered back.
+* Enable per component through FDDDCharacterMovementConfig::UseBatchedUpdate.
+*/
+UCLASS()
+class PCPP_COMPONENTS_API UDDDMovementBatcher : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+protected:
+	// Components managed by the batcher.
+	TArray<TWeakObjectPtr<UDDDCharacterMovement>> Components;
+
+	// Components that are awake this frame. Only filled during Tick, from Components that were just checked.
+	TArray<UDDDCharacterMovement*> Active;
+
+	FDDDMovementBatch Batch;
+
+	void Gather();
+	void Process(float DeltaTime);
+	void Scatter();
+
+public:
+	UDDDMovementBatcher();
+
+	// Adds a component to the batch. The component will no longer need to tick for bookkeeping.
+	void Register(UDDDCharacterMovement* Component);
+
+	// Removes a component from the batch.
+	void Unregister(UDDDCharacterMovement* Component);
+
+	// How many components have to be registered before the work is split across worker threads.
+	int32 ParallelThreshold;
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual ETickableTickType GetTickableTickType() const override { return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional; }
+};
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
+#include "Containers/Queue.h"
 #include "InputBroadcaster.generated.h"
 
 UENUM(BlueprintType)
@@ -27,9 +28,29 @@ enum class EDefaultInputLayout : uint8 {
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FInputBroadcastDelegate, EInputBroadcastState, BroadcastState, float, BroadcastMagnitude);
 
+// Native observer for every input sent through BroadcastInput. (Input, State, Magnitude)
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FAnyInputBroadcastDelegate, uint8, EInputBroadcastState, float);
+
+// Native observer of a single input, avoids the reflection overhead of FInputBroadcastDelegate. (State, Magnitude)
+DECLARE_MULTICAST_DELEGATE_TwoParams(FNativeInputBroadcastDelegate, EInputBroadcastState, float);
+
+// A single input waiting in the queue.
+struct FInputBroadcastEvent {
+	uint8 Input;
+	EInputBroadcastState State;
+	float Magnitude;
+
+	// When the input was queued, for latency tracing.
+	double QueuedSeconds;
+	uint64 QueuedFrame;
+};
+
 /*
 * Handles the broadcasting of inputs from the Controller.
 * Allows for safe observation of inputs from outside of the Actor context.
+*
+* When Queued, BroadcastInput only pushes into a lock-free MPSC queue (safe from any thread) and the events are dispatched in one batch later in the frame,
+* keeping observers (ie: menu widgets) out of input processing. With AutoDispatch off the queue is left to a single consumer calling DrainQueue (ie: the Slate thread).
 */
 UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
 class PCPP_COMPONENTS_API UInputBroadcaster : public UActorComponent
@@ -40,9 +61,41 @@ protected:
 	// Array containing a variable number of Delegates
 	TArray<FInputBroadcastDelegate> InputList;
 
+	// Native counterpart of InputList.
+	TArray<FNativeInputBroadcastDelegate> NativeInputList;
+
+	TQueue<FInputBroadcastEvent, EQueueMode::Mpsc> Queue;
+
+	// Sends a single input to every observer.
+	void Dispatch(uint8 Input, EInputBroadcastState State, float Magnitude);
+
+	// Ticks only while the queue is dispatched by the component.
+	void _UpdateTickEnabled();
+
+	virtual void BeginPlay() override;
+
+	// Dispatches the queue when queued.
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
 public:	
 	UInputBroadcaster();
 
+	// Push inputs into a queue to be dispatched later in the frame instead of dispatching them immediately. Use SetQueued at runtime.
+	UPROPERTY(EditAnywhere)
+	bool Queued;
+
+	// Whether the queue is dispatched by the component's tick, otherwise a consumer is expected to call ProcessQueue / DrainQueue. Use SetAutoDispatch at runtime.
+	UPROPERTY(EditAnywhere)
+	bool AutoDispatch;
+
+	// Game thread only. Turning it off dispatches whatever is still queued (when AutoDispatch).
+	UFUNCTION(BlueprintCallable)
+	void SetQueued(bool NewQueued);
+
+	// Game thread only.
+	UFUNCTION(BlueprintCallable)
+	void SetAutoDispatch(bool NewAutoDispatch);
+
 	/* 
 	* Usage, Pass it an enum::MAX value to intiialize the input list.
 	* The enum should correspond to controller inputs.
@@ -52,6 +105,41 @@ public:
 	/*
 	* Retrieves the delegate (by pointer) corresponding to the enum::ButtonInput
 	* This value should not be stored anywhere.
+	* For observers only, producers broadcasting it directly bypass the native observers and the queue. Use BroadcastInput.
 	*/
 	FInputBroadcastDelegate* GetInputDelegate(uint8 Input);
+
+	/*
+	* Native version of GetInputDelegate, preferred for C++ observers.
+	* This value should not be stored anywhere.
+	*/
+	FNativeInputBroadcastDelegate* GetNativeInputDelegate(uint8 Input);
+
+	/*
+	* Broadcasts an input to the corresponding delegates and to OnAnyInput, or queues it when Queued (any thread).
+	* The only way inputs should be produced, so that native observers (ie: recorders, menus) see the input.
+	*/
+	UFUNCTION(BlueprintCallable)
+	void BroadcastInput(uint8 Input, EInputBroadcastState State, float Magnitude);
+
+	// Dispatches every queued input, oldest first. Game thread only. Returns the amount dispatched.
+	int32 ProcessQueue();
+
+	/*
+	* Pops every queued input into Callback without dispatching any delegate, oldest first.
+	* Only a single consumer may drain the queue at a time. Returns the amount drained.
+	*/
+	template<typename F>
+	int32 DrainQueue(F Callback) {
+		int32 Drained = 0;
+		FInputBroadcastEvent Event;
+		while (Queue.Dequeue(Event)) {
+			Callback(Event);
+			Drained++;
+		}
+		return Drained;
+	}
+
+	// Native observers of every input sent through BroadcastInput.
+	FAnyInputBroadcastDelegate OnAnyInput;
 };
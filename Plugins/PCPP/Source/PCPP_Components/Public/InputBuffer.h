@@ -0,0 +1,106 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "InputBuffer.generated.h"
+
+UENUM(BlueprintType)
+enum class EBufferedInputType : uint8 {
+	Axis,
+	Pressed,
+	Released
+};
+
+/*
+* A single timestamped input event.
+*/
+struct FBufferedInputEvent {
+	// World time the event was recorded at.
+	float Time;
+
+	// Caller defined input id, typically an enum value.
+	uint8 Input;
+
+	EBufferedInputType Type;
+
+	// Axis value, 1.0 for pressed and 0.0 for released.
+	float Value;
+
+	// Set once an action has been consumed so that it isn't handled twice.
+	bool Consumed;
+};
+
+/*
+* Records timestamped axis / action events into a fixed-capacity ring and lets the owner drain them once per frame.
+* Actions stay in the ring after draining so they can be consumed later within a buffering window (ie: dodge pressed slightly early).
+* When full the oldest event is overwritten. Nothing is allocated after construction.
+*/
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class PCPP_COMPONENTS_API UInputBuffer : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	static const int32 Capacity = 64;
+
+	// The maximum amount of distinct axis ids that are tracked.
+	static const int32 MaxAxes = 16;
+
+protected:
+	FBufferedInputEvent Events[Capacity];
+
+	// Index of the oldest event.
+	int32 Head;
+
+	// Amount of valid events.
+	int32 Count;
+
+	// Amount of events (from the tail) that haven't been drained yet.
+	int32 Undrained;
+
+	// Latest value per axis id.
+	float AxisValues[MaxAxes];
+
+	void Push(uint8 Input, EBufferedInputType Type, float Value);
+
+	FORCEINLINE FBufferedInputEvent& At(int32 Index) { return Events[(Head + Index) % Capacity]; };
+
+public:
+	UInputBuffer();
+
+	// Records the current value of an axis.
+	void RecordAxis(uint8 Input, float Value);
+
+	// Records an action being pressed / released.
+	void RecordAction(uint8 Input, bool Pressed);
+
+	/*
+	* Calls Callback for every event recorded since the last drain, oldest first.
+	* Axis values are also folded into GetAxis so most consumers only need the actions.
+	*/
+	template<typename F>
+	void Drain(F Callback) {
+		for (int32 i = Count - Undrained; i < Count; ++i) {
+			Callback(At(i));
+		}
+		Undrained = 0;
+	}
+
+	// Latest recorded value of the axis.
+	float GetAxis(uint8 Input) const;
+
+	/*
+	* Consumes the most recent unconsumed press of the action if it happened within Window seconds.
+	* Returns whether a press was consumed.
+	*/
+	bool ConsumeAction(uint8 Input, float Window);
+
+	// Whether an unconsumed press of the action exists within Window seconds.
+	bool HasBufferedAction(uint8 Input, float Window);
+
+	// Drops every event.
+	UFUNCTION(BlueprintCallable)
+	void Clear();
+};
@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+
+DECLARE_STATS_GROUP(TEXT("PCPP Input Latency"), STATGROUP_PCPPInputLatency, STATCAT_Advanced);
+
+// Points an input is followed through, measured from the input reaching UDDDDriver.
+enum class EInputLatencyStage : uint8 {
+	// AddInputVector.
+	InputVector,
+	// UDDDCharacterMovement mode change.
+	ModeChange,
+	// UDodgeSystem LaunchCharacter.
+	Launch,
+	// First movement tick after the input produced an input vector, a mode change or a launch, the point where it is applied.
+	MovementTick,
+	// UInputBroadcaster BroadcastInput -> dispatch. (Queued mode)
+	BroadcastDispatch,
+	MAX
+};
+
+/*
+* An input being followed. Owned by whatever applies the input (ie: UDDDCharacterMovement).
+*/
+struct FInputLatencyTrace {
+	double StartSeconds;
+	uint64 StartFrame;
+	uint8 Input;
+
+	// Stages already sampled, a stage is only sampled once per trace.
+	uint8 Reached;
+
+	bool Active;
+
+	FInputLatencyTrace() : StartSeconds(0.0), StartFrame(0), Input(0), Reached(0), Active(false) {}
+};
+
+/*
+* Input -> motion latency tracing. Enabled with pcpp.Input.TraceLatency 1.
+*
+* Samples are kept per stage in a fixed ring, percentiles of the end to end (MovementTick) latency are exposed via stat PCPPInputLatency
+* and every sample is written to the PCPPInputLatency CSV profiler category. pcpp.Input.LatencyReport logs every stage.
+* Game thread only.
+*/
+class PCPP_COMPONENTS_API FInputLatency {
+public:
+	static const int32 MaxSamples = 512;
+
+	static bool IsEnabled();
+
+	// Starts following an input unless the trace is already following an older one.
+	static void Begin(FInputLatencyTrace& Trace, uint8 Input);
+
+	// Samples a stage of the trace.
+	static void Mark(FInputLatencyTrace& Trace, EInputLatencyStage Stage);
+
+	// Samples MovementTick and stops following.
+	static void End(FInputLatencyTrace& Trace);
+
+	// Stops following without a sample, ie: the input was never applied.
+	static void Drop(FInputLatencyTrace& Trace);
+
+	// Whether the input already produced an InputVector, ModeChange or Launch. (Not still waiting in a UInputBuffer)
+	static bool IsApplied(const FInputLatencyTrace& Trace);
+
+	static void AddSample(EInputLatencyStage Stage, float Milliseconds, uint32 Frames);
+
+	// Latency (ms) at Percent (0-100) of the recent samples of a stage, 0 without samples.
+	static float GetPercentile(EInputLatencyStage Stage, float Percent);
+
+	// Logs percentiles of every stage.
+	static void Report();
+
+	static void Reset();
+
+private:
+	struct FStageSamples {
+		float Milliseconds[MaxSamples];
+		uint32 Frames[MaxSamples];
+		int32 Head;
+		int32 Count;
+	};
+
+	static FStageSamples Samples[(int32)EInputLatencyStage::MAX];
+
+	static float ComputePercentile(const float* Values, int32 Count, float Percent);
+};
@@ -0,0 +1,138 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "InputBroadcaster.h"
+#include "InputRecorder.generated.h"
+
+class UDDDDriver;
+class APawn;
+class AController;
+
+UENUM(BlueprintType)
+enum class EInputRecorderMode : uint8 {
+	Disabled,
+	Record,
+	Replay
+};
+
+// Where a recorded input came from.
+UENUM()
+enum class EInputRecordSource : uint8 {
+	Driver,
+	Broadcaster
+};
+
+/*
+* A single recorded input.
+*/
+struct FInputRecord {
+	// Frame relative to the start of recording.
+	uint32 Frame;
+
+	EInputRecordSource Source;
+
+	// EDDDDriverInput for the driver, the broadcaster's input index otherwise.
+	uint8 Input;
+
+	// EInputBroadcastState for the broadcaster, unused for the driver.
+	uint8 State;
+
+	float Value;
+};
+
+// Timing of a single replayed frame.
+struct FInputReplayFrame {
+	uint32 Frame;
+	float WallMs;
+	float GameThreadMs;
+};
+
+/*
+* Records the inputs going through the owner's UDDDDriver and UInputBroadcaster with frame numbers into a compact binary file,
+* and replays them with a fixed timestep while writing a frame time CSV.
+*
+* Command line (overrides Mode / FileName):
+*   -PCPPRecordInput=<File>	Record into <File>.
+*   -PCPPReplayInput=<File>	Replay <File>, writes <File>.csv with frame times, exits when done if -PCPPReplayExit is set.
+*   -PCPPReplayFPS=<Rate>	Fixed timestep used for replays. (Default 60)
+*
+* ie: UE4Editor <Project> <Map> -game -nullrhi -PCPPReplayInput=Saved/Fight.pcppinput -PCPPReplayExit
+*/
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class PCPP_COMPONENTS_API UInputRecorder : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UInputRecorder();
+
+	UPROPERTY(EditAnywhere)
+	EInputRecorderMode Mode;
+
+	// Relative paths are relative to the project's Saved directory.
+	UPROPERTY(EditAnywhere)
+	FString FileName;
+
+	// Whether the recorder is currently capturing inputs.
+	FORCEINLINE bool IsRecording() const { return Mode == EInputRecorderMode::Record && Active; };
+
+	// Whether the recorder is currently feeding inputs. Live input should be ignored meanwhile.
+	FORCEINLINE bool IsReplaying() const { return Mode == EInputRecorderMode::Replay && Active; };
+
+	// Records an input handled by UDDDDriver.
+	void RecordDriverInput(uint8 Input, float Value);
+
+	// Writes the recording to disk. Called automatically on EndPlay.
+	UFUNCTION(BlueprintCallable)
+	void Save();
+
+protected:
+	bool Active;
+
+	// Recording / replay starts once, when the owner is first locally controlled.
+	bool Started;
+
+	// Engine frame recording / replay started on.
+	uint64 StartFrame;
+
+	// Frames since the start of recording / replay.
+	FORCEINLINE uint32 GetFrame() const { return (uint32)(GFrameCounter - StartFrame); };
+
+	TArray<FInputRecord> Records;
+
+	// Replay cursor into Records.
+	int32 ReplayIndex;
+
+	// Wall clock of the previous replay frame and the collected frame times.
+	double LastFrameSeconds;
+	TArray<FInputReplayFrame> FrameTimes;
+
+	bool ExitAfterReplay;
+
+	UDDDDriver* Driver;
+	UInputBroadcaster* Broadcaster;
+
+	FDelegateHandle BroadcasterHandle;
+
+	FString GetFullPath() const;
+
+	void OnBroadcasterInput(uint8 Input, EInputBroadcastState State, float Magnitude);
+
+	UFUNCTION()
+	void OnControllerChanged(APawn* Pawn, AController* OldController, AController* NewController);
+
+	void Start();
+
+	bool Load();
+
+	void WriteFrameTimes();
+
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+};
@@ -0,0 +1,175 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Serialization/BitWriter.h"
+#include "NetReplicate.h"
+#include "PCPP_Tuple.h"
+#include "PCPP_UE4.h"
+
+/*
+* Wire format of a TNetChannel argument. Symmetric like INetReplicatable::SerializeReplication,
+* specialize it for types that have a more compact form than their FArchive operator.
+*/
+template<typename T>
+struct TNetChannelSerializer {
+	static void Serialize(FArchive& Ar, T& Value) {
+		Ar << Value;
+	}
+};
+
+template<>
+struct TNetChannelSerializer<bool> {
+	static void Serialize(FArchive& Ar, bool& Value) {
+		PCPP_UE4::Quantize::Bool(Ar, Value);
+	}
+};
+
+template<>
+struct TNetChannelSerializer<uint32> {
+	static void Serialize(FArchive& Ar, uint32& Value) {
+		PCPP_UE4::Quantize::Int(Ar, Value);
+	}
+};
+
+template<>
+struct TNetChannelSerializer<int32> {
+	// Zig zag, small negative values stay small.
+	static void Serialize(FArchive& Ar, int32& Value) {
+		uint32 Encoded = ((uint32)Value << 1) ^ (uint32)(Value >> 31);
+		PCPP_UE4::Quantize::Int(Ar, Encoded);
+		Value = (int32)(Encoded >> 1) ^ -(int32)(Encoded & 1);
+	}
+};
+
+template<>
+struct TNetChannelSerializer<FVector> {
+	static void Serialize(FArchive& Ar, FVector& Value) {
+		PCPP_UE4::Quantize::Vector(Ar, Value);
+	}
+};
+
+template<>
+struct TNetChannelSerializer<FRotator> {
+	static void Serialize(FArchive& Ar, FRotator& Value) {
+		PCPP_UE4::Quantize::Rotator(Ar, Value);
+	}
+};
+
+template<>
+struct TNetChannelSerializer<FName> {
+	// Bit archives don't serialize names, they travel as strings.
+	static void Serialize(FArchive& Ar, FName& Value) {
+		FString String = Value.ToString();
+		Ar << String;
+		Value = FName(*String);
+	}
+};
+
+template<typename ElementType>
+struct TNetChannelSerializer<TArray<ElementType>> {
+	// Elements a received array may claim.
+	static const uint32 MaxNum = 1024;
+
+	static void Serialize(FArchive& Ar, TArray<ElementType>& Value) {
+		uint32 Num = Value.Num();
+		PCPP_UE4::Quantize::Int(Ar, Num);
+		if (Num > MaxNum) {
+			Ar.SetError();
+			return;
+		}
+		if (Ar.IsLoading()) {
+			Value.SetNum(Num);
+		}
+		for (auto& Element : Value) {
+			TNetChannelSerializer<ElementType>::Serialize(Ar, Element);
+		}
+	}
+};
+
+/*
+* Typed message channel over UNetReplicate. The serialization of Args is generated at compile time (TNetChannelSerializer per argument),
+* messages are bit packed and dispatched straight to the handler, no FJsonObject or field lookups involved.
+*
+* Usage (member of a component, bound on every machine):
+*	TNetChannel<FVector, float, bool> HitChannel;
+*	HitChannel.Bind(NetReplicate, TEXT("Hit"), false, [this](const FVector& Location, const float& Damage, const bool& Critical) { ... });
+*	HitChannel.Send(Location, Damage, Critical);
+*/
+template<typename... Args>
+class TNetChannel {
+public:
+	typedef TFunction<void(const Args&...)> FHandler;
+
+	TNetChannel() : Key(0) {}
+
+	~TNetChannel() {
+		Unbind();
+	}
+
+	// Not copyable, the binding refers to this channel.
+	TNetChannel(const TNetChannel&) = delete;
+	TNetChannel& operator=(const TNetChannel&) = delete;
+
+	// Unreliable channels may lose messages. Returns false if the name collides with another channel of Source.
+	bool Bind(UNetReplicate* InSource, FName Name, bool Reliable, FHandler InHandler) {
+		Unbind();
+		if (!InSource) {
+			return false;
+		}
+		Handler = MoveTemp(InHandler);
+		uint16 NewKey = 0;
+		if (!InSource->BindChannel(Name, Reliable, [this](FArchive& Ar) { Receive(Ar); }, NewKey)) {
+			return false;
+		}
+		Source = InSource;
+		Key = NewKey;
+		return true;
+	}
+
+	void Unbind() {
+		if (Source.IsValid()) {
+			Source->UnbindChannel(Key);
+		}
+		Source.Reset();
+	}
+
+	bool IsBound() const {
+		return Source.IsValid();
+	}
+
+	// Owner or server, see UNetReplicate::SendMessage.
+	void Send(Args... Values) {
+		if (!Source.IsValid()) {
+			return;
+		}
+		TTuple<Args...> Message(MoveTemp(Values)...);
+		FBitWriter Writer(0, true);
+		Serialize(Writer, Message);
+		TArray<uint8> Bytes(Writer.GetData(), (int32)Writer.GetNumBytes());
+		Source->SendMessage(Key, Bytes);
+	}
+
+	// Writes (Ar.IsSaving) or reads (Ar.IsLoading) every argument of a message in order.
+	static void Serialize(FArchive& Ar, TTuple<Args...>& Message) {
+		PCPP_Tuple::ForEach(Message, [&Ar](auto& Value) {
+			TNetChannelSerializer<typename TDecay<decltype(Value)>::Type>::Serialize(Ar, Value);
+		});
+	}
+
+private:
+	TWeakObjectPtr<UNetReplicate> Source;
+	uint16 Key;
+	FHandler Handler;
+
+	void Receive(FArchive& Ar) {
+		TTuple<Args...> Message;
+		Serialize(Ar, Message);
+		if (!Ar.IsError() && Handler) {
+			PCPP_Tuple::Apply(Message, [this](const Args&... Values) {
+				Handler(Values...);
+			});
+		}
+	}
+};
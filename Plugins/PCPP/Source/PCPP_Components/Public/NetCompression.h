@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/*
+* Compression of full (reliable) UNetReplicate payloads, ie: ForceUpdate of large inventories / quest states.
+*
+* Payloads above pcpp.Net.CompressionThreshold bytes are compressed with pcpp.Net.CompressionCodec and flagged with ENetPayloadFlags::Compressed,
+* they are only kept compressed when that makes them smaller. The flag byte (and prediction header) stay as they are, followed by
+* Codec (uint8), Dictionary (uint8), packed uncompressed Length and the compressed rest of the payload.
+*
+* Dictionaries are samples of a repetitive schema (ie: a typical JSON payload) registered under the same id on every machine,
+* components opt in with INetReplicatable::GetCompressionDictionary. They use zlib with a preset dictionary.
+* Ratio and CPU cost are exposed via stat PCPPNetReplicate and pcpp.Net.CompressionReport.
+*/
+class PCPP_COMPONENTS_API FNetCompression {
+public:
+	enum ECodec : uint8 {
+		Zlib,
+		LZ4,
+		// Zlib with a registered preset dictionary.
+		ZlibDictionary,
+		MAX
+	};
+
+	// Compresses a payload in place if it is large enough and compression pays off. Returns whether it was compressed.
+	static bool Compress(TArray<uint8>& Payload, uint8 Dictionary = 0);
+
+	// Restores a payload made by Compress in place, uncompressed payloads are left alone. Returns false if it couldn't be read.
+	static bool Decompress(TArray<uint8>& Payload);
+
+	static bool IsCompressed(const TArray<uint8>& Payload);
+
+	// Id 1-255, the same bytes have to be registered on every machine.
+	static void RegisterDictionary(uint8 Id, const TArray<uint8>& Dictionary);
+
+	// UTF-8 of a sample payload.
+	static void RegisterDictionary(uint8 Id, const FString& Sample);
+
+	// Logs the compression ratio and time spent.
+	static void Report();
+
+private:
+	static TMap<uint8, TArray<uint8>> Dictionaries;
+
+	// Totals for Report.
+	static int64 RawBytes;
+	static int64 CompressedBytes;
+	static int64 Compressions;
+	static int64 Skipped;
+	static uint64 CompressCycles;
+	static int64 Decompressions;
+	static uint64 DecompressCycles;
+
+	// Bytes that stay uncompressed, the flag byte and prediction header.
+	static int32 GetHeaderSize(const TArray<uint8>& Payload);
+
+	static bool ZlibDictionaryCompress(const TArray<uint8>& Dictionary, const uint8* Data, int32 Length, TArray<uint8>& Out);
+
+	// Decoders of received (untrusted) data, fail instead of asserting. Dictionary may be null.
+	static bool ZlibUncompress(const TArray<uint8>* Dictionary, const uint8* Data, int32 Length, uint8* Out, int32 OutLength);
+
+	static bool LZ4Uncompress(const uint8* Data, int32 Length, uint8* Out, int32 OutLength);
+};
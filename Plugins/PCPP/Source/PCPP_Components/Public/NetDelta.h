@@ -0,0 +1,109 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/*
+* A payload identified by the id it was sent with.
+*/
+struct FNetDeltaBaseline {
+	uint16 Id;
+	TArray<uint8> Payload;
+};
+
+/*
+* Delta packets used by UNetReplicate, for a single component and a single receiver.
+*
+* Packet: Flags (uint8), Id (uint16), then either
+*   Keyframe: the full payload.
+*   Delta: BaselineId (uint16), NewLength, SpanCount and per span (Skip, Length, Bytes) against the baseline. (Packed ints)
+*
+* The sender only deltas against the last payload the receiver acknowledged so that lost packets never corrupt state,
+* and sends a keyframe when there is no acknowledged baseline or every KeyframeInterval packets.
+*/
+class PCPP_COMPONENTS_API FNetDeltaSender {
+public:
+	// Packets kept until acknowledged.
+	static const int32 MaxHistory = 8;
+
+	// Encode calls an unacknowledged packet is given before it is resent.
+	static const int32 ResendInterval = 4;
+
+	FNetDeltaSender();
+
+	/*
+	* Makes the packet for Payload. Returns false when nothing has to be sent,
+	* either the receiver acknowledged this exact payload or it is in flight and not due for a resend.
+	*/
+	bool Encode(const TArray<uint8>& Payload, int32 KeyframeInterval, TArray<uint8>& Out);
+
+	// Whether the receiver has this exact payload, Encode would send nothing.
+	bool IsAcknowledged(const TArray<uint8>& Payload) const;
+
+	// The receiver has the payload sent with Id. Returns how many older packets were never acknowledged. (Lost)
+	int32 Ack(uint16 Id);
+
+	// Forget everything, the next packet will be a keyframe.
+	void Reset();
+
+	// Forget what the receiver has but keep counting ids, for receivers that may have lost their state.
+	void ForceKeyframe();
+
+	// The receiver got Payload some other way (ie: reliably), nothing is sent until it changes. It has no id so the next packet is a keyframe.
+	void Deliver(const TArray<uint8>& Payload);
+
+private:
+	// Sent and not yet acknowledged, oldest first.
+	TArray<FNetDeltaBaseline> History;
+
+	FNetDeltaBaseline Acked;
+	bool HasAcked;
+
+	// Acked.Payload was delivered without an id, it isn't a baseline.
+	bool Delivered;
+
+	uint16 NextId;
+	int32 SendsSinceKeyframe;
+	int32 SkipsSinceSend;
+};
+
+class PCPP_COMPONENTS_API FNetDeltaReceiver {
+public:
+	FNetDeltaReceiver();
+
+	/*
+	* Rebuilds the payload from a packet made by FNetDeltaSender and outputs the id to acknowledge.
+	* Returns false for stale / duplicate packets and deltas against a baseline that is no longer known.
+	*/
+	bool Decode(const TArray<uint8>& Packet, TArray<uint8>& OutPayload, uint16& OutId);
+
+private:
+	// Most recent payloads, candidates for the sender's baseline.
+	TArray<FNetDeltaBaseline> Baselines;
+
+	uint16 LatestId;
+	bool HasLatest;
+};
+
+class PCPP_COMPONENTS_API FNetDelta {
+public:
+	// Whether sequence id A comes after B. (Wraps around)
+	static FORCEINLINE bool IsNewer(uint16 A, uint16 B) { return (int16)(A - B) > 0; };
+
+	// Writes the spans of New that differ from Base.
+	static void WriteSpans(const TArray<uint8>& Base, const TArray<uint8>& New, FArchive& Ar);
+
+	// Applies spans written by WriteSpans onto Base.
+	static bool ReadSpans(const TArray<uint8>& Base, FArchive& Ar, TArray<uint8>& Out);
+
+	// Unchanged bytes between two changes that are still merged into one span. (Cheaper than a new span header)
+	static const int32 MergeGap = 3;
+
+	// Largest payload a packet may claim to rebuild.
+	static const uint32 MaxPayloadSize = 1 << 20;
+
+	enum EFlags : uint8 {
+		Keyframe = 1 << 0
+	};
+};
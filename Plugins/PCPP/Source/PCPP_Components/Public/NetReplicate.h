@@ -5,17 +5,198 @@
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
 #include "NetReplicatable.h"
+#include "NetDelta.h"
+#include "NetReplicateConnection.h"
 #include "NetReplicate.generated.h"
 
+/*
+* First byte of every replication payload.
+*/
+namespace ENetPayloadFlags {
+	enum Type : uint8 {
+		None = 0,
+		// The rest of the payload is INetReplicatable::SerializeReplication output, otherwise UTF-8 JSON.
+		Binary = 1 << 0,
+		// Owner -> Server only, Sequence (uint16) and Epoch (uint8) of INetReplicatable prediction follow the flag byte.
+		Predicted = 1 << 1,
+		// The rest of the payload is compressed. (FNetCompression)
+		Compressed = 1 << 2
+	};
+}
+
+/*
+* RPCs sent on behalf of UNetReplicate.
+*/
+namespace ENetReplicateRPC {
+	enum Type : uint8 {
+		// Owner -> Server
+		OwnerReliable,
+		OwnerUnreliable,
+		OwnerMessages,
+		// Server -> Owner
+		OwnerAck,
+		PredictionAck,
+		// Server -> Client (UNetReplicateConnection)
+		ServerReliable,
+		ServerUnreliable,
+		ServerMessages,
+		// Client -> Server (UNetReplicateConnection)
+		ClientAck,
+		MAX
+	};
+}
+
+/*
+* Server -> connection state of a single replicated component.
+*/
+struct FNetReplicateConnectionState {
+	FNetDeltaSender Sender;
+
+	// Staleness for UNetReplicateScheduler.
+	double LastSendTime;
+
+	FNetReplicateConnectionState() : LastSendTime(0.0) {}
+};
+
+/*
+* Delta state of a single replicated component.
+*/
+struct FNetReplicateComponentState {
+	// Owner -> Server.
+	FNetDeltaSender ToServer;
+	FNetDeltaReceiver FromOwner;
+
+	// Server -> Clients. Latest known payload and what each connection acknowledged.
+	TArray<uint8> Latest;
+	TMap<TWeakObjectPtr<UNetReplicateConnection>, FNetReplicateConnectionState> ToConnections;
+
+	// Client.
+	FNetDeltaReceiver FromServer;
+};
+
+/*
+* How often a component's payload actually changes, drives its adaptive send interval.
+*/
+struct FNetReplicateRateStats {
+	// Scheduled payloads compared and how many of them differed from the previous one.
+	int32 Samples;
+	int32 Changes;
+
+	// Recent fraction of samples that changed. (Moving average)
+	float ChangeRate;
+
+	uint32 LastHash;
+	bool HasHash;
+
+	FNetReplicateRateStats() : Samples(0), Changes(0), ChangeRate(0.f), LastHash(0), HasHash(false) {}
+};
+
+/*
+* Receiver of a message channel. (TNetChannel)
+*/
+struct FNetChannelBinding {
+	FName Name;
+	bool Reliable;
+	// Reads the message from a bit archive.
+	TFunction<void(FArchive&)> Receive;
+};
+
+/*
+* A locally simulated step of a predicted component.
+*/
+struct FNetPredictionStep {
+	uint16 Sequence;
+	// INetReplicatable::SerializePredictionMove output.
+	TArray<uint8> Move;
+	// Payload of the state the step led to.
+	TArray<uint8> State;
+};
+
+/*
+* Prediction state of a single component. (INetReplicatable::UsesPrediction)
+*/
+struct FNetPredictionState {
+	// Owner, steps the server has not acknowledged yet, oldest first.
+	TArray<FNetPredictionStep> History;
+	uint16 NextSequence;
+
+	// Bumped by the server on every correction, the owner sends the last one it applied and older ones are refused.
+	uint8 Epoch;
+
+	// Server, latest sequence received from the owner.
+	uint16 LastSequence;
+
+	// Owner.
+	int32 Acks;
+	int32 Corrections;
+	int32 Rewinds;
+	int32 ReplayedSteps;
+
+	FNetPredictionState() : NextSequence(0), Epoch(0), LastSequence(0), Acks(0), Corrections(0), Rewinds(0), ReplayedSteps(0) {}
+};
+
+/*
+* Slot of an INetReplicatable in UNetReplicate::Entries, indexed by its net ID. Component is null until registered.
+*/
+struct FNetReplicateEntry {
+	INetReplicatable* Component;
+
+	// Seconds between unreliable updates, 0 or less only sends on ForceUpdate / RequestReplication.
+	// Adapts between MinInterval and MaxInterval to the observed change rate.
+	float Interval;
+	float MinInterval;
+	float MaxInterval;
+	double NextSendTime;
+
+	FNetReplicateRateStats Rate;
+
+	// Weight of the component's updates in UNetReplicateScheduler.
+	float Importance;
+
+	ENetReplicationAudience Audience;
+
+	// Payload waiting for the next bundle.
+	TArray<uint8> Pending;
+	bool HasPending;
+	bool PendingReliable;
+
+	FNetReplicateComponentState State;
+
+	bool Predicted;
+	FNetPredictionState Prediction;
+
+	FNetReplicateEntry() : Component(nullptr), Interval(0.f), MinInterval(0.f), MaxInterval(0.f), NextSendTime(0.0), Importance(1.f), Audience(ENetReplicationAudience::Everyone), HasPending(false), PendingReliable(false), Predicted(false) {}
+};
+
 /*
 * Component that handles replication on behalf of the owner.
 * It is assumed that the owner is aware of it's own state so the owner alone is unaffected by the multicast events.
+*
+* Unreliable updates are delta compressed per receiver: the owner sends the server deltas against what the server acknowledged,
+* and the server sends every client (through its UNetReplicateConnection) deltas against what that client acknowledged.
+* Unchanged state costs nothing once acknowledged. Reliable updates (ForceUpdate) are sent whole, compressed when large. (FNetCompression)
+*
+* Every update of an actor is coalesced into one bundle RPC per net update (ticked at the owner's NetUpdateFrequency),
+* entries are addressed by their net ID. Bundle: per entry packed NetId, packed Length, Bytes.
+* Net IDs are the index of the component among the owner's INetReplicatable components sorted by name, so every machine agrees on them.
+* Server -> client traffic is ranked and budgeted per connection by UNetReplicateScheduler,
+* and only goes to connections the actor is relevant to. (Viewer distance, ENetReplicationAudience)
+* Sizes, drops and serialization time per component class are recorded by FNetReplicateTelemetry.
+*
+* Predicted components (INetReplicatable::UsesPrediction) send the sequence of their latest recorded step with their state.
+* The server acknowledges it, or answers with its own state when Validate refuses the update or ServerCorrect overrides it.
+* The owner then rewinds and replays its unacknowledged steps if the prediction for that step is off by more than the component's tolerance.
+*
+* Messages (TNetChannel) are events rather than state: they go from the owner to the server and on to every relevant connection,
+* or from the server to every relevant connection and the owner. Message bundle: per message Channel (uint16), packed Length, Bytes.
 */
 UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
 class PCPP_COMPONENTS_API UNetReplicate : public UActorComponent
 {
 	GENERATED_BODY()
 
+	friend class UNetReplicateScheduler;
+
 public:	
 	// Sets default values for this component's properties
 	UNetReplicate();
@@ -23,50 +204,191 @@ public:
 private:
 	APawn* PawnOwner;
 
-	TMap<FString, INetReplicatable*> CachedComponents;
+	// Indexed by net ID.
+	TArray<FNetReplicateEntry> Entries;
 
+	// Assigns net IDs to the owner's INetReplicatable components that have none. Assigned IDs never change.
+	void _AssignNetIds();
+
+	UFUNCTION()
 	void _ProcessReliableRequestFromInterface(UActorComponent* Target, bool Reliable);
 
-protected:
-	// Overridable function to handle validation for the Server RPCs.
-	virtual bool Validate(const FString& ObjectID, const FString& ReplicateData);
+	UFUNCTION()
+	void _RecordPredictionFromInterface(UActorComponent* Target);
+
+	// Owner, inserts the prediction header into a payload of a predicted entry.
+	static void _AddPredictionHeader(const FNetPredictionState& Prediction, const TArray<uint8>& Payload, TArray<uint8>& Out);
 
-	/* Retrieves a component as a INetReplicatable interface and caches it for faster access later.
-	* If needed it can be further specialized to bypass the hash table lookups.
+	/* Server, whether a payload from the owner is taken. Strips the prediction header of predicted entries,
+	* which are acknowledged or corrected into PredictionAcks.
 	*/
-	virtual INetReplicatable* GetCachedComponentByTag(const FString& ObjectID);
+	bool _ServerAccept(int32 Index, TArray<uint8>& Payload, FArchive& PredictionAcks);
+
+	// Prediction acks: per entry packed Index, Sequence, Epoch, Corrected (uint8), if corrected packed Length and the server's payload.
+	void _WritePredictionAck(FArchive& Ar, int32 Index, bool Corrected);
+
+	// Owner, applies the authoritative state and replays the steps after Sequence.
+	void _Rewind(FNetReplicateEntry& Entry, const TArray<uint8>& Authoritative, uint16 Sequence);
+
+	static float _PredictionError(INetReplicatable* Component, const TArray<uint8>& Predicted, const TArray<uint8>& Authoritative);
+
+	// Bound message channels by key.
+	TMap<uint16, FNetChannelBinding> Channels;
+
+	// Owner, messages waiting for the next net update. (Unreliable, Reliable)
+	TArray<uint8> QueuedMessages[2];
+
+	void _FlushMessages();
+
+	// Calls the bound channels of every message in a bundle.
+	void _DispatchMessages(const TArray<uint8>& Bundle);
 
-	// Passes on the request to INetReplicatable for per component processing of the FJsonObject
-	void ProcessReplicationRequest(const FString& ObjectID, const FString& ReplicateData);
+	// Server, passes a bundle on to every relevant connection, and the owner's when the server sent it.
+	void _ForwardMessages(const TArray<uint8>& Bundle, bool Reliable, bool IncludeOwner);
+
+	// Flag byte + UTF-8 JSON.
+	static void _MakeJsonPayload(const FString& Data, TArray<uint8>& Out);
+
+	// Returns the bytes written.
+	static int32 _WriteBundleEntry(FArchive& Ar, int32 Index, const TArray<uint8>& Data);
+
+	// Calls Callback(Index, Data) per entry of a bundle, stops at the first malformed or unknown entry.
+	template<typename Callback>
+	void _ReadBundle(const TArray<uint8>& Bundle, Callback Foo);
+
+	// Acks: per entry packed Index, Id.
+	static void _WriteAck(FArchive& Ar, int32 Index, uint16 Id);
+
+	// Owner, gathers due and pending updates into the bundles to the server.
+	void _OwnerSend();
+
+	// Backs off static payloads and tightens volatile ones.
+	void _AdaptInterval(FNetReplicateEntry& Entry, bool Changed);
+
+	// Server, maintained by UNetReplicateScheduler.
+	TSet<TWeakObjectPtr<UNetReplicateConnection>> RelevantConnections;
+	FName NetTeam;
+
+protected:
+	// Overridable function to handle validation for the Server RPCs.
+	virtual bool Validate(int32 NetId, const TArray<uint8>& Payload);
+
+	// Passes on the request to INetReplicatable for per component processing of the payload.
+	void ProcessReplicationRequest(int32 Index, const TArray<uint8>& Payload);
 
 	APawn* GetPawnOwner();
 
-	// Finally Processes Replication 
-	UFUNCTION(NetMulticast, Unreliable, WithValidation)
-	void BroadcastMulticastUnreliable(const FString& ObjectID, const FString& ReplicateData);
+	// Bundle of delta packets from the owner, stored for the clients.
+	UFUNCTION(Server, Unreliable, WithValidation)
+	void BroadcastServerUnreliable(const TArray<uint8>& Bundle);
+
+	// Acknowledges delta packets from the owner.
+	UFUNCTION(Client, Unreliable)
+	void ClientAck(const TArray<uint8>& Acks);
 
-	// Finally Processes Replication
-	UFUNCTION(NetMulticast, Reliable, WithValidation)
-	void BroadcastMulticastReliable(const FString& ObjectID, const FString& ReplicateData);
+	// Bundle of full payloads, passed on to the relevant connections.
+	UFUNCTION(Server, Reliable, WithValidation)
+	void BroadcastServerReliable(const TArray<uint8>& Bundle);
 
-	// Passes to Unreliable Multicast
+	// Acknowledges or corrects the steps of predicted components.
+	UFUNCTION(Client, Unreliable)
+	void ClientPredictionAck(const TArray<uint8>& Acks);
+
+	// Bundles of messages from the owner, dispatched on the server and passed on to the relevant connections.
 	UFUNCTION(Server, Unreliable, WithValidation)
-	void BroadcastServerUnreliable(const FString& ObjectID, const FString& ReplicateData);
+	void ServerMessages(const TArray<uint8>& Bundle);
+
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerReliableMessages(const TArray<uint8>& Bundle);
 
-	// Passes to Reliable Multicast
-	UFUNCTION(NetMulticast, Reliable, WithValidation)
-	void BroadcastServerReliable(const FString& ObjectID, const FString& ReplicateData);
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 public:	
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	// Packets between full keyframes, these recover receivers that lost their baseline.
+	UPROPERTY(EditAnywhere)
+	int32 KeyframeInterval;
+
+	// Adapt each component's send interval to how often its payload changes.
+	UPROPERTY(EditAnywhere)
+	bool AdaptiveReplication;
+
+	// Slowest send interval of components registered without their own MaxInterval.
+	UPROPERTY(EditAnywhere)
+	float MaxReplicationInterval;
+
+	// Factor applied to the interval per unchanged sample, a changed sample halves it.
+	UPROPERTY(EditAnywhere)
+	float ReplicationBackoff;
+
+	// Unacknowledged steps kept per predicted component, older ones can no longer be replayed.
+	UPROPERTY(EditAnywhere)
+	int32 MaxPredictionHistory;
+
+	// RPCs sent by this process and the bytes of their bundles, per ENetReplicateRPC.
+	static int64 RPCCounts[ENetReplicateRPC::MAX];
+	static int64 RPCBytes[ENetReplicateRPC::MAX];
+
+	static void CountRPC(ENetReplicateRPC::Type Type, int32 Bytes);
+
+	// Change rate and current interval of a registered component, null otherwise.
+	const FNetReplicateRateStats* GetRateStats(int32 NetId, float& OutInterval) const;
+
+	// Logs the rates of every component of every UNetReplicate. (pcpp.Net.ReplicationRates)
+	static void ReportRates();
+
+	// Client, a bundle of delta packets from the server.
+	void ReceiveBundle(UNetReplicateConnection* Connection, const TArray<uint8>& Bundle);
 
-	/* Request for the replication of a JSON String across clients for an Object with the given tag.
-	* Automatically routes to the appropriate RPC.
+	// Client, a bundle of full payloads from the server.
+	void ReceiveReliable(const TArray<uint8>& Bundle);
+
+	// Client, a bundle of messages from the server.
+	void ReceiveMessages(const TArray<uint8>& Bundle);
+
+	/*
+	* Binds a message channel, the key is derived from Name so every machine agrees on it.
+	* Returns false if another channel of this component already uses the key.
 	*/
-	void RequestReplication(const FString& ObjectTag, const FString& ObjectData, bool Reliable = false);
+	bool BindChannel(FName Name, bool Reliable, TFunction<void(FArchive&)> Receive, uint16& OutKey);
+
+	void UnbindChannel(uint16 Key);
+
+	// Sends a message (bit packed) on a bound channel. Owner or server only, the sender's own channel is not called.
+	void SendMessage(uint16 Key, const TArray<uint8>& Message);
+
+	// Server, a connection acknowledged delta packets.
+	void AckBundle(UNetReplicateConnection* Connection, const TArray<uint8>& Acks);
+
+	// Serializes the component's current state into a payload (flag byte + binary or UTF-8 JSON).
+	static void CreatePayload(INetReplicatable* Component, TArray<uint8>& Out);
+
+	// Applies a payload made by CreatePayload to the component. Returns false if it couldn't be read.
+	static bool ApplyPayload(INetReplicatable* Component, const TArray<uint8>& Payload);
+
+	// Server, imposes a payload on a registered predicted component. The owner rewinds to it and replays its later steps.
+	void ServerCorrect(int32 NetId, const TArray<uint8>& Payload);
+
+	// Prediction counters of a registered predicted component, null otherwise.
+	const FNetPredictionState* GetPredictionState(int32 NetId) const;
+
+	/* Request for the replication of a payload across clients for the registered component with the given net ID.
+	* Queued for the next bundle.
+	*/
+	void RequestReplication(int32 NetId, const TArray<uint8>& Payload, bool Reliable = false);
+
+	// JSON String version of RequestReplication.
+	void RequestReplication(int32 NetId, const FString& ObjectData, bool Reliable = false);
 
 	/*
 	* Register the implementor of the INetReplicatable interface to begin replication.
+	* Every party registers the same components, updates are sent at most once per net update.
+	* Importance weighs the component against others when a connection's bandwidth budget is tight.
+	* ReplicationFrequency is the fastest send interval, the interval backs off up to MaxInterval (MaxReplicationInterval when 0) while the payload is static.
 	*/
-	void RegisterReplication(float ReplicationFrequency, INetReplicatable* ReplicatingComponent);
+	void RegisterReplication(float ReplicationFrequency, INetReplicatable* ReplicatingComponent, float Importance = 1.f, float MaxInterval = 0.f);
 
 };
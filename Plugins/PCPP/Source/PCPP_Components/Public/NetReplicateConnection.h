@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "NetReplicateConnection.generated.h"
+
+class UNetReplicate;
+class APlayerController;
+
+/*
+* Per connection endpoint for UNetReplicate, added by the server to each remote PlayerController.
+* As the PlayerController is owned by its connection the RPCs here reach exactly one client, which lets the server send each client its own deltas.
+*/
+UCLASS(ClassGroup=(Custom))
+class PCPP_COMPONENTS_API UNetReplicateConnection : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UNetReplicateConnection();
+
+	// Server only. Finds or creates the connection component of a PlayerController.
+	static UNetReplicateConnection* Get(APlayerController* Controller);
+
+	// Bundle of delta packets for the components of Source.
+	UFUNCTION(Client, Unreliable)
+	void ClientReceiveBundle(UNetReplicate* Source, const TArray<uint8>& Bundle);
+
+	// Bundle of full payloads for the components of Source.
+	UFUNCTION(Client, Reliable)
+	void ClientReceiveReliable(UNetReplicate* Source, const TArray<uint8>& Bundle);
+
+	// Bundles of messages of Source. (TNetChannel)
+	UFUNCTION(Client, Unreliable)
+	void ClientReceiveMessages(UNetReplicate* Source, const TArray<uint8>& Bundle);
+
+	UFUNCTION(Client, Reliable)
+	void ClientReceiveReliableMessages(UNetReplicate* Source, const TArray<uint8>& Bundle);
+
+	// Acknowledges delta packets of the components of Source.
+	UFUNCTION(Server, Unreliable, WithValidation)
+	void ServerAck(UNetReplicate* Source, const TArray<uint8>& Acks);
+};
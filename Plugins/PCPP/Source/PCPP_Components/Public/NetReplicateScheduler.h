@@ -0,0 +1,99 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "NetReplicateScheduler.generated.h"
+
+class UNetReplicate;
+class UNetReplicateConnection;
+class APlayerController;
+class AController;
+
+// Team of a controller for ENetReplicationAudience::TeamOnly, NAME_None for no team.
+DECLARE_DELEGATE_RetVal_OneParam(FName, FNetTeamResolver, AController*);
+
+/*
+* An update a connection is missing.
+*/
+struct FNetReplicateCandidate {
+	UNetReplicate* Source;
+	int32 Index;
+	float Score;
+};
+
+/*
+* A remote connection and where it is looking from.
+*/
+struct FNetReplicateViewer {
+	UNetReplicateConnection* Connection;
+	APlayerController* Controller;
+	FVector Location;
+	FName Team;
+};
+
+/*
+* Server side scheduler for UNetReplicate traffic.
+* Every send (pcpp.Net.SendRate) each connection is given its share of a bytes per second budget (pcpp.Net.BytesPerSecond),
+* the updates it is missing are ranked by the actor's NetPriority, the component's importance, distance to the connection's view and staleness,
+* then sent in that order until the budget runs out. Staleness grows while an update is skipped so nothing starves.
+*
+* Interest management: viewers are hashed into a 2D grid, an actor becomes relevant to a connection within pcpp.Net.RelevancyRadius
+* and stops being relevant beyond the radius plus pcpp.Net.RelevancyHysteresis. Irrelevant connections receive nothing,
+* and resume with a keyframe once relevant again.
+*/
+UCLASS()
+class PCPP_COMPONENTS_API UNetReplicateScheduler : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+protected:
+	TArray<TWeakObjectPtr<UNetReplicate>> Sources;
+
+	// Bytes each connection may still send, unspent budget carries over up to pcpp.Net.MaxBurstSeconds.
+	TMap<TWeakObjectPtr<UNetReplicateConnection>, float> Credit;
+
+	// Seconds since the last send.
+	float Accumulator;
+
+	// Reused between sends.
+	TArray<FNetReplicateCandidate> Candidates;
+	TArray<FNetReplicateViewer> Viewers;
+	TMap<FIntPoint, TArray<int32, TInlineAllocator<4>>> Grid;
+
+	float ComputeScore(UNetReplicate* Source, int32 Index, const FVector& ViewLocation);
+
+	// Whether a viewer on ViewerTeam may receive a component of Source. (ENetReplicationAudience)
+	bool CanReceive(UNetReplicate* Source, int32 Index, const FName& ViewerTeam);
+
+	FName GetTeam(AController* Controller);
+
+	// Viewers of every remote connection, hashed into Grid by CellSize.
+	void GatherViewers(float CellSize);
+
+	// Updates the connections Source is relevant to.
+	void UpdateRelevancy(UNetReplicate* Source, float Radius, float CellSize);
+
+	void SendTo(const FNetReplicateViewer& Viewer, float Seconds, double Now);
+
+public:
+	UNetReplicateScheduler();
+
+	// Resolves teams for ENetReplicationAudience::TeamOnly components, nobody shares a team while unbound.
+	FNetTeamResolver TeamResolver;
+
+	void Register(UNetReplicate* Source);
+
+	void Unregister(UNetReplicate* Source);
+
+	// Sends full payloads of Source to every relevant connection now, reliably.
+	void SendReliable(UNetReplicate* Source, const TArray<int32, TInlineAllocator<8>>& Indices);
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual ETickableTickType GetTickableTickType() const override { return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional; }
+};
@@ -0,0 +1,89 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+
+DECLARE_STATS_GROUP(TEXT("PCPP Net Replicate"), STATGROUP_PCPPNetReplicate, STATCAT_Advanced);
+
+class INetReplicatable;
+
+/*
+* What a replicated component class (and tag, its first ComponentTags entry) has cost this process.
+*/
+struct FNetTelemetryRecord {
+	// Payload sizes kept for the rolling histogram.
+	static const int32 MaxSamples = 256;
+
+	// Class or Class.Tag
+	FString Name;
+
+	// Bundle entries sent and their bytes. (Packets after delta compression)
+	int64 Sends;
+	int64 ReliableSends;
+	int64 Bytes;
+
+	// Unreliable packets that were never acknowledged or were discarded by the receiver.
+	int64 Drops;
+
+	// CreatePayload / ApplyPayload calls and the time spent in them.
+	int64 Serializes;
+	uint64 SerializeCycles;
+	int64 Applies;
+	uint64 ApplyCycles;
+
+	// Full payload sizes of the most recent serializes. (Ring)
+	uint16 Sizes[MaxSamples];
+	int32 Head;
+	int32 Count;
+
+	// PCPPNetReplicate CSV stat of the bytes.
+	FName CsvBytesName;
+
+	FNetTelemetryRecord() : Sends(0), ReliableSends(0), Bytes(0), Drops(0), Serializes(0), SerializeCycles(0), Applies(0), ApplyCycles(0), Head(0), Count(0) {}
+};
+
+/*
+* Per component class bandwidth accounting of UNetReplicate. Enabled with pcpp.Net.Telemetry 1.
+*
+* Totals are exposed via stat PCPPNetReplicate and per frame in the PCPPNetReplicate CSV profiler category (bytes per class included).
+* pcpp.Net.TelemetryTop [N] [Bytes|Sends|Drops|Serialize] logs the biggest consumers,
+* pcpp.Net.TelemetryHistogram [Filter] logs the payload size histogram of matching classes. Game thread only.
+*/
+class PCPP_COMPONENTS_API FNetReplicateTelemetry {
+public:
+	// Power of two payload size buckets, the first holds up to 8 bytes and the last everything above 1024.
+	static const int32 NumBuckets = 9;
+
+	static bool IsEnabled();
+
+	// Record of the component's class and tag, INDEX_NONE while disabled.
+	static int32 GetSlot(INetReplicatable* Component);
+
+	static void RecordSend(int32 Slot, int32 Bytes, bool Reliable);
+
+	static void RecordDrops(int32 Slot, int32 Count);
+
+	static void RecordSerialize(int32 Slot, uint64 Cycles, int32 PayloadSize);
+
+	static void RecordApply(int32 Slot, uint64 Cycles);
+
+	static const FNetTelemetryRecord* GetRecord(int32 Slot);
+
+	// Rolling payload size histogram of a record.
+	static void GetHistogram(int32 Slot, int32 (&OutBuckets)[NumBuckets]);
+
+	// Payload size at Percent (0-100) of the recent serializes of a record.
+	static int32 GetSizePercentile(int32 Slot, float Percent);
+
+	static void Top(const TArray<FString>& Args);
+
+	static void Histogram(const TArray<FString>& Args);
+
+	static void Reset();
+
+private:
+	static TArray<FNetTelemetryRecord> Records;
+	static TMap<TPair<const UClass*, FName>, int32> Slots;
+};
@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "Pollable.h"
 #include "Components/ActorComponent.h"
+#include "Async/Future.h"
 #include "PollingClientComponent.generated.h"
 
 UENUM(BlueprintType)
@@ -14,6 +15,40 @@ enum class EPollingMode : uint8 {
 	IsServer,
 };
 
+class UPollingClientComponent;
+
+UENUM(BlueprintType)
+enum class EPollStatus : uint8 {
+	Answered,
+	// No response within the timeout, a late response is dropped.
+	TimedOut,
+	// The response could not be parsed.
+	Malformed,
+	// The poller was destroyed or the target went away before the response.
+	Cancelled,
+	// Wrong context or no target, nothing was sent.
+	NotSent,
+};
+
+/*
+* Outcome of a single poll request.
+*/
+struct PCPP_COMPONENTS_API FPollResult {
+	uint32 RequestId;
+	EPollStatus Status;
+	FString Endpoint;
+	// Empty unless Answered.
+	FJsonObject Response;
+	// The component that answered. (Server context: the polled client, Client context: the requester itself)
+	UPollingClientComponent* Responder;
+	// Seconds from sending to resolving.
+	float Latency;
+
+	FPollResult() : RequestId(0), Status(EPollStatus::NotSent), Responder(nullptr), Latency(0.f) {}
+};
+
+typedef TFunction<void(const FPollResult&)> FPollCallback;
+
 /*
 * Acts as a liasion for polling data between Client and Server contexts.
 * Auto-detects if it is in Server Context (Component of AGamemode) 
@@ -21,6 +56,11 @@ enum class EPollingMode : uint8 {
 * 
 * The parent or a sibling that implements IPollable will define how to respond to requests as well as how to handle data once
 * it is successfully polled.
+*
+* Every poll carries a request id, so any number of polls (also to the same endpoint) can be in flight at once.
+* TryPoll responses go to IPollable, Poll / PollServer / PollClient responses go only to their callback or future,
+* resolved once on the game thread: answered, timed out (pcpp.Poll.Timeout) or cancelled.
+*	Poller->PollServer(TEXT("Inventory")).Then([](TFuture<FPollResult> Result) { ... });
 */
 UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
 class PCPP_COMPONENTS_API UPollingClientComponent : public UActorComponent {
@@ -43,28 +83,76 @@ protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
 
-	// Callback From ClientPolled so that the server receives the polled data.
-	UFUNCTION(Client, Reliable)
-	void ServerReceiveResponse(const FString& Endpoint, const FString& Data, UPollingClientComponent* Caller);
+	// A poll waiting for its response.
+	struct FPendingPoll {
+		FString Endpoint;
+		// Component expected to answer. (The polled client in server context)
+		TWeakObjectPtr<UPollingClientComponent> Target;
+		double SentTime;
+		// 0 never times out.
+		double Deadline;
+		// Unset for TryPoll, which responds through IPollable.
+		FPollCallback Callback;
+	};
+
+	// Last issued request id, 0 is never used.
+	uint32 _LastRequestId;
+
+	TMap<uint32, FPendingPoll> _Pending;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Sends one request to Target (nullptr is the server) and tracks it until resolved. Returns the request id, 0 if not sent.
+	uint32 _Send(UPollingClientComponent* Target, const FString& Endpoint, float Timeout, FPollCallback Callback);
+
+	// Matches a response to its request, Responder must be the polled component.
+	void _ReceiveResponse(uint32 RequestId, const FString& Data, UPollingClientComponent* Responder);
 
-	// Callback from ServerPolled so that the client receives the polled data.
+	void _Resolve(uint32 RequestId, EPollStatus Status, const FJsonObject& Response, UPollingClientComponent* Responder);
+
+	// Builds the response to Endpoint with the IPollable implementation.
+	FString _MakeResponse(const FString& Endpoint);
+
+	// Response to a ClientPolled request, Executes on Server and is handed to the GameMode poller.
 	UFUNCTION(Server, Reliable)
-	void ClientReceiveResponse(const FString& Endpoint, const FString& Data);
+	void ServerReceiveResponse(uint32 RequestId, const FString& Data);
 
-	// Client Requests Endpoint, Executes on Server
+	// Response to a ServerPolled request, Executes on Client.
 	UFUNCTION(Client, Reliable)
-	void ServerPolled(const FString& Endpoint, UPollingClientComponent* Caller);
+	void ClientReceiveResponse(uint32 RequestId, const FString& Data);
 
-	// Server Requests Endpoint, Executes on Client
+	// Client Requests Endpoint, Executes on Server
 	UFUNCTION(Server, Reliable)
-	void ClientPolled(const FString& Endpoint);
-
+	void ServerPolled(uint32 RequestId, const FString& Endpoint);
 
+	// Server Requests Endpoint, Executes on Client
+	UFUNCTION(Client, Reliable)
+	void ClientPolled(uint32 RequestId, const FString& Endpoint);
 
 public:
 	// Attempts to poll corresponding UPollingClientComponent(s) in the autodetected context (either client or server)
 	UFUNCTION(BlueprintCallable)
 	void TryPoll(const FString Endpoint);
+
+	// Polls in the autodetected context, Callback is called once per request (once per polled client in server context.)
+	// Timeout in seconds, negative uses pcpp.Poll.Timeout and 0 waits forever. Returns the number of requests sent.
+	int32 Poll(const FString& Endpoint, FPollCallback Callback, float Timeout = -1.f);
+
+	// Client context, polls the server.
+	TFuture<FPollResult> PollServer(const FString& Endpoint, float Timeout = -1.f);
+
+	// Server context, polls a single client poller.
+	TFuture<FPollResult> PollClient(UPollingClientComponent* Client, const FString& Endpoint, float Timeout = -1.f);
+
+	// Server context, polls every client poller.
+	TArray<TFuture<FPollResult>> PollClients(const FString& Endpoint, float Timeout = -1.f);
+
+	// Resolves the request as Cancelled, its response will be dropped.
+	void CancelPoll(uint32 RequestId);
+
+	int32 GetPendingPolls() const { return _Pending.Num(); }
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 	
 	virtual void BeginDestroy() override;
 };
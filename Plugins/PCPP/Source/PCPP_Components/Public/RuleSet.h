@@ -7,6 +7,8 @@
 #include "Components/ActorComponent.h"
 #include "RuleSet.generated.h"
 
+class AController;
+
 USTRUCT()
 struct PCPP_COMPONENTS_API FSpawnPoint {
 	GENERATED_BODY()
@@ -35,5 +37,8 @@ protected:
 public:	
 	URuleSet();
 	virtual void InitRuleSet(const TMap<FName, TArray<FSpawnPoint> >& SpawnPoints);
+
+	// Team of a controller, the tag of the spawn point it occupies. NAME_None if it has none.
+	virtual FName GetTeam(AController* Controller);
 		
 };
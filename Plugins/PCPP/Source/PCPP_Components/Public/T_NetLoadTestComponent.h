@@ -0,0 +1,104 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NetReplicatable.h"
+#include "Pollable.h"
+#include "Components/ActorComponent.h"
+#include "NetChannel.h"
+#include "T_NetLoadTestComponent.generated.h"
+
+class UNetReplicate;
+class URPGCore;
+class UPollingClientComponent;
+
+/*
+* Scripted pawn behaviour for the network load test. (PCPP.Net.LoadTest)
+* The locally controlled side walks a circle around its spawn point, spends and regenerates Health / Stamina on the sibling URPGCore
+* and polls through the sibling UPollingClientComponent. Position and stats replicate through the sibling UNetReplicate.
+* With Predict every step is recorded for INetReplicatable prediction and replayed after corrections.
+* Every lap's hit is announced on a TNetChannel.
+*/
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class PCPP_COMPONENTS_API UT_NetLoadTestComponent : public UActorComponent, public INetReplicatable, public IPollable
+{
+	GENERATED_BODY()
+
+public:
+	UT_NetLoadTestComponent();
+
+	// Radius (cm) of the walked circle.
+	UPROPERTY(EditAnywhere)
+	float Radius;
+
+	// Radians per second around the circle.
+	UPROPERTY(EditAnywhere)
+	float AngularSpeed;
+
+	// Fastest send interval passed to UNetReplicate.
+	UPROPERTY(EditAnywhere)
+	float ReplicationFrequency;
+
+	// Seconds between polls, 0 disables polling.
+	UPROPERTY(EditAnywhere)
+	float PollInterval;
+
+	// Polls sent at once every interval, all in flight together.
+	UPROPERTY(EditAnywhere)
+	int32 PollsPerInterval;
+
+	// Record steps for prediction, read on registration.
+	UPROPERTY(EditAnywhere)
+	bool Predict;
+
+	// Distance (cm) a predicted position may be off before the owner rewinds.
+	UPROPERTY(EditAnywhere)
+	float PredictionTolerance;
+
+	// Polls sent, answered and timed out on this process.
+	static int64 PollsSent;
+	static int64 PollsAnswered;
+	static int64 PollsTimedOut;
+
+	// Hit messages received by this process.
+	static int64 HitsReceived;
+
+private:
+	UNetReplicate* NetReplicate;
+	URPGCore* RPGCore;
+	UPollingClientComponent* Poller;
+
+	FVector Origin;
+	float Angle;
+	float PollTimer;
+
+	// Length of the last simulated step, the prediction move.
+	float StepSeconds;
+
+	// Location, Damage.
+	TNetChannel<FVector, float> HitChannel;
+
+	// Walks and changes stats, replayed steps don't force updates.
+	void _Simulate(float DeltaTime, bool Replaying);
+
+	static void _SerializeState(FArchive& Ar, FVector& Location, FRotator& Rotation, float& HP, float& Stamina);
+
+protected:
+	virtual void BeginPlay() override;
+
+public:
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	// INetReplicatable
+	virtual bool UsesBinaryReplication() override { return true; }
+	virtual void SerializeReplication(FArchive& Ar) override;
+	virtual bool UsesPrediction() override { return Predict; }
+	virtual void SerializePredictionMove(FArchive& Ar) override;
+	virtual void ReplayPrediction(FArchive& Move) override;
+	virtual float GetPredictionError(FArchive& Predicted, FArchive& Authoritative) override;
+	virtual float GetPredictionTolerance() override { return PredictionTolerance; }
+
+	// IPollable
+	virtual FJsonObject MakeResponseObject(const FString& Endpoint) override;
+};
@@ -5,10 +5,21 @@
 #include "CoreMinimal.h"
 #include "UObject/Interface.h"
 #include "Dom/JsonObject.h"
-#include "Kismet/KismetSystemLibrary.h"
 #include "NetReplicatable.generated.h"
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FReliableReplicateDelegate, UActorComponent*, Target, bool, Reliable);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FRecordPredictionDelegate, UActorComponent*, Target);
+
+// Connections that receive a component's updates, in addition to the server.
+UENUM()
+enum class ENetReplicationAudience : uint8 {
+	// Every connection the owning actor is relevant to.
+	Everyone,
+	// No other client, the owner already knows its own state.
+	OwnerOnly,
+	// Connections on the owner's team the owning actor is relevant to.
+	TeamOnly
+};
 
 // This class does not need to be modified.
 UINTERFACE(MinimalAPI)
@@ -31,30 +42,16 @@ private:
 
 	// Endpoint for listening component to listen on.
 	FReliableReplicateDelegate _ReliableReplicationDelegate;
+	FRecordPredictionDelegate _RecordPredictionDelegate;
 
-	// Utilize for ticking of unreliable updates once registered.
-	FTimerDelegate _ReplicationTimerDelegate;
-	FTimerHandle _ReplicationTimerHandle;
-
-	// Generates a unique tag for the object and on initialization sets it onto the owning component.
-	FString _GeneratedTag;
-	bool _TagGenerated;
-	const FString& _GetTag() {
-		// Get tag (lazy.)
-		if (_TagGenerated) {
-			return _GeneratedTag;
-		}
-
-		// Generate tag (lazy.)
-		auto Self = Cast<UActorComponent>(this);
-		if (Self) {
-			// Display names for components must be unique.
-			_GeneratedTag = UKismetSystemLibrary::GetDisplayName(Self);
-			Self->ComponentTags.Add(FName(*_GeneratedTag));
-		}
-		return _GeneratedTag;
-	}
+	// Assigned by UNetReplicate on registration.
+	int32 _NetId = INDEX_NONE;
 public:
+	// Identifies the component on the wire, the same on every machine. INDEX_NONE until registered.
+	int32 GetNetId() const {
+		return _NetId;
+	}
+
 	/*
 	* Create the object that will be used for replication.
 	* This is the object that will be both sent and received.
@@ -66,6 +63,63 @@ public:
 	// For whatever reason FJsonObject is not usable by blueprint functions. :(
 	virtual void ReceiveReplicate(const FJsonObject& Data) {}
 
+	/*
+	* Implementors returning true are replicated through SerializeReplication instead of CreateReplicationData / ReceiveReplicate.
+	* Binary payloads are typically 5-10x smaller than JSON and skip the string conversions.
+	*/
+	virtual bool UsesBinaryReplication() {
+		return false;
+	}
+
+	/*
+	* Writes (Ar.IsSaving) or reads (Ar.IsLoading) the replicated state, the same code handles both directions.
+	* See PCPP_UE4::Quantize for compact floats / vectors / rotators.
+	*/
+	virtual void SerializeReplication(FArchive& Ar) {}
+
+	// FNetCompression dictionary of the component's full payloads, 0 for none. (See FNetCompression::RegisterDictionary)
+	virtual uint8 GetCompressionDictionary() {
+		return 0;
+	}
+
+	// Who receives the component's updates. Read once on registration.
+	virtual ENetReplicationAudience GetReplicationAudience() {
+		return ENetReplicationAudience::Everyone;
+	}
+
+	/*
+	* Opt-in prediction, binary replication only.
+	* The owner records every locally simulated step with RecordPrediction, the server acknowledges the latest step it received
+	* and corrects the owner when it rejects or overrides its state. The owner only rewinds to the corrected state and replays
+	* the later steps (ReplayPrediction) when GetPredictionError exceeds GetPredictionTolerance.
+	*/
+	virtual bool UsesPrediction() {
+		return false;
+	}
+
+	// Writes the input of the step just simulated, read back by ReplayPrediction.
+	virtual void SerializePredictionMove(FArchive& Ar) {}
+
+	// Simulates a recorded step again on top of the current (rewound) state.
+	virtual void ReplayPrediction(FArchive& Move) {}
+
+	// Distance between two states written by SerializeReplication, read them without applying. Any difference by default.
+	virtual float GetPredictionError(FArchive& Predicted, FArchive& Authoritative) {
+		return MAX_flt;
+	}
+
+	virtual float GetPredictionTolerance() {
+		return 0.f;
+	}
+
+	// Records the step just simulated. (Owner, requires registration.)
+	void RecordPrediction() {
+		auto Self = Cast<UActorComponent>(this);
+		if (Self) {
+			_RecordPredictionDelegate.Broadcast(Self);
+		}
+	}
+
 	// Force an update. (Only way to push forward reliable requests.)
 	void ForceUpdate(bool Reliable = true) {
 		auto Self = Cast<UActorComponent>(this);
@@ -5,17 +5,17 @@
 
 void UCharacterSelectWidget::AddToScreen(ULocalPlayer* LocalPlayer, int32 ZOrder) {
 	Super::AddToScreen(LocalPlayer, ZOrder);
-	// Binding
+	// Binding. Native, the callers only forward to the blueprint delegates.
 	auto Owner = GetOwningPlayer();
 	if (Owner) {
 		auto InputBroadcaster = Cast<UInputBroadcaster>(Owner->GetComponentByClass(UInputBroadcaster::StaticClass()));
 		if (InputBroadcaster) {
-			(InputBroadcaster->GetInputDelegate(uint8(EDefaultInputLayout::Cancel)))->AddDynamic(this, &UCharacterSelectWidget::OnCancel_Caller);
-			(InputBroadcaster->GetInputDelegate(uint8(EDefaultInputLayout::Confirm)))->AddDynamic(this, &UCharacterSelectWidget::OnSubmit_Caller);
-			(InputBroadcaster->GetInputDelegate(uint8(EDefaultInputLayout::Down)))->AddDynamic(this, &UCharacterSelectWidget::OnDown_Caller);
-			(InputBroadcaster->GetInputDelegate(uint8(EDefaultInputLayout::Left)))->AddDynamic(this, &UCharacterSelectWidget::OnLeft_Caller);
-			(InputBroadcaster->GetInputDelegate(uint8(EDefaultInputLayout::Right)))->AddDynamic(this, &UCharacterSelectWidget::OnRight_Caller);
-			(InputBroadcaster->GetInputDelegate(uint8(EDefaultInputLayout::Up)))->AddDynamic(this, &UCharacterSelectWidget::OnUp_Caller);
+			(InputBroadcaster->GetNativeInputDelegate(uint8(EDefaultInputLayout::Cancel)))->AddUObject(this, &UCharacterSelectWidget::OnCancel_Caller);
+			(InputBroadcaster->GetNativeInputDelegate(uint8(EDefaultInputLayout::Confirm)))->AddUObject(this, &UCharacterSelectWidget::OnSubmit_Caller);
+			(InputBroadcaster->GetNativeInputDelegate(uint8(EDefaultInputLayout::Down)))->AddUObject(this, &UCharacterSelectWidget::OnDown_Caller);
+			(InputBroadcaster->GetNativeInputDelegate(uint8(EDefaultInputLayout::Left)))->AddUObject(this, &UCharacterSelectWidget::OnLeft_Caller);
+			(InputBroadcaster->GetNativeInputDelegate(uint8(EDefaultInputLayout::Right)))->AddUObject(this, &UCharacterSelectWidget::OnRight_Caller);
+			(InputBroadcaster->GetNativeInputDelegate(uint8(EDefaultInputLayout::Up)))->AddUObject(this, &UCharacterSelectWidget::OnUp_Caller);
 		}
 	}
 }
@@ -26,12 +26,12 @@ void UCharacterSelectWidget::RemoveFromParent() {
 	if (Owner) {
 		auto InputBroadcaster = Cast<UInputBroadcaster>(Owner->GetComponentByClass(UInputBroadcaster::StaticClass()));
 		if (InputBroadcaster) {
-			(InputBroadcaster->GetInputDelegate(uint8(EDefaultInputLayout::Cancel)))->RemoveDynamic(this, &UCharacterSelectWidget::OnCancel_Caller);
-			(InputBroadcaster->GetInputDelegate(uint8(EDefaultInputLayout::Confirm)))->RemoveDynamic(this, &UCharacterSelectWidget::OnSubmit_Caller);
-			(InputBroadcaster->GetInputDelegate(uint8(EDefaultInputLayout::Down)))->RemoveDynamic(this, &UCharacterSelectWidget::OnDown_Caller);
-			(InputBroadcaster->GetInputDelegate(uint8(EDefaultInputLayout::Left)))->RemoveDynamic(this, &UCharacterSelectWidget::OnLeft_Caller);
-			(InputBroadcaster->GetInputDelegate(uint8(EDefaultInputLayout::Right)))->RemoveDynamic(this, &UCharacterSelectWidget::OnRight_Caller);
-			(InputBroadcaster->GetInputDelegate(uint8(EDefaultInputLayout::Up)))->RemoveDynamic(this, &UCharacterSelectWidget::OnUp_Caller);
+			(InputBroadcaster->GetNativeInputDelegate(uint8(EDefaultInputLayout::Cancel)))->RemoveAll(this);
+			(InputBroadcaster->GetNativeInputDelegate(uint8(EDefaultInputLayout::Confirm)))->RemoveAll(this);
+			(InputBroadcaster->GetNativeInputDelegate(uint8(EDefaultInputLayout::Down)))->RemoveAll(this);
+			(InputBroadcaster->GetNativeInputDelegate(uint8(EDefaultInputLayout::Left)))->RemoveAll(this);
+			(InputBroadcaster->GetNativeInputDelegate(uint8(EDefaultInputLayout::Right)))->RemoveAll(this);
+			(InputBroadcaster->GetNativeInputDelegate(uint8(EDefaultInputLayout::Up)))->RemoveAll(this);
 		}
 	}
 	Super::RemoveFromParent();